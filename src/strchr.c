@@ -8,6 +8,26 @@
 *    - the new style Max object,
 *    - dynamic strings,
 *    - attributes.
+*
+*  The from attribute skips characters at the start of the string, or at
+*  the end with reverse 1, in which case the string is searched backwards.
+*  The nth attribute selects the occurrence to report.
+*
+*  Character set mode (charset 1):  the whole right string is a set of
+*  characters, and the position of any of them is found, as with strpbrk().
+*  With charset 2, the position of a character not in the set is found,
+*  as with strspn().  The set is compiled into a bitmap when it changes,
+*  and with SSSE3 16 characters are classified at a time with nibble lookups.
+*
+*  The report attribute selects the output:  the first position (0),
+*  the list of all positions (1), or the number of occurrences (2).
+*  All and count scan 32 characters at a time, within the part of the string
+*  selected by from and reverse.
+*
+*  Indexed mode (indexed 1):  the positions of each character in the left
+*  string are sorted by character when it changes, so that the queries for
+*  any character are answered by binary search, without scanning the string.
+*  It applies to the single character mode.
 */
 
 /****************************************************************
@@ -17,9 +37,17 @@
 #include "ext_obex.h"
 #include "dstring.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STR_SSE2 1
+#include <intrin.h>
+#endif
+
 /****************************************************************
 *  Preprocessor
 */
+#define STR_MAP_TEST(map, c) ((map)[(c) >> 3] & (1 << ((c) & 7)))
+#define STR_POS_ALLOC 16
+#define STR_POS_MAX   32767   // outlet_list() takes a short count
 
 /****************************************************************
 *  Max object structure
@@ -30,13 +58,32 @@ typedef struct _strchr
 
   void *inl_proxy;
   long  inl_proxy_ind;
-  void *outl_int;
+  void *outl_any;
   
-  t_dstr i_dstr1;
-  t_dstr i_dstr2;
-  long   o_pos;
+  t_dstr  i_dstr1;
+  t_dstr  i_dstr2;
+  long    o_pos;
+  long    o_cnt;
+  t_atom *o_pos_arr;
+  short   o_pos_max;
+  short   o_pos_cnt;
+
+  unsigned char s_map[32];      // bitmap of the characters of the set
+  unsigned char s_nib[2][16];   // same by low nibble, for bytes below and above 0x80
+  char          s_dirty;
+
+  t_dstr_int   *ix_pos;         // positions grouped by character
+  t_dstr_int    ix_max;
+  t_dstr_int    ix_start[257];  // start of the positions of each character
+  char          ix_dirty;
 
   long  mode;
+  long  from;
+  long  reverse;
+  long  nth;
+  long  charset;
+  long  report;
+  long  indexed;
   long  fprecision;
   char  format[6];
 
@@ -47,6 +94,11 @@ typedef struct _strchr
 */
 static t_class *strchr_class = NULL;
 
+/****************************************************************
+*  Global flag for the SSSE3 instructions, tested at initialization
+*/
+static char str_ssse3 = 0;
+
 /****************************************************************
 *  Function declarations
 */
@@ -62,14 +114,35 @@ void  strchr_anything (t_strchr *x, t_symbol *sym, long argc, t_atom *argv);
 void  strchr_set      (t_strchr *x, t_symbol *sym, long argc, t_atom *argv);
 void  strchr_post     (t_strchr *x);
 
+void  strchr_input    (t_strchr *x, t_dstr dstr, char output);
 void  strchr_action   (t_strchr *x);
+void  strchr_prepare  (t_strchr *x, t_dstr set);
+t_dstr_int strchr_find (t_strchr *x, const char *str, t_dstr_int len, char c);
+t_dstr_int strchr_rfind(t_strchr *x, const char *str, t_dstr_int len, char c);
+void  strchr_scan     (t_strchr *x, const char *str, t_dstr_int beg, t_dstr_int end, char c);
+void  strchr_add      (t_strchr *x, t_atom_long n);
+void  strchr_index    (t_strchr *x, t_dstr hay);
+void  strchr_query    (t_strchr *x, unsigned char c, t_dstr_int beg, t_dstr_int end);
 void  strchr_output   (t_strchr *x);
 
+t_dstr_int str_memrchr       (const char *str, char c, t_dstr_int len);
+t_dstr_int str_set_find      (t_strchr *x, const char *str, t_dstr_int len);
+t_dstr_int str_lower_bound   (const t_dstr_int *arr, t_dstr_int cnt, t_dstr_int val);
+t_dstr_int str_set_rfind     (t_strchr *x, const char *str, t_dstr_int len);
+#ifdef STR_SSE2
+__m128i   str_set_cmp        (__m128i v, __m128i nib_low, __m128i nib_high);
+#endif
 t_dstr    str_proxy_to_dstr  (t_strchr *x);
 t_dstr    str_cat_atom       (t_strchr *x, t_dstr dstr, t_atom *atom);
 t_dstr    str_cat_args       (t_strchr *x, t_dstr dstr, long argc, t_atom *argv);
 t_max_err str_mode_set       (t_strchr *x, void *attr, long argc, t_atom *argv);
 t_max_err str_fprecision_set (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_from_set       (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_reverse_set    (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_nth_set        (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_charset_set    (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_report_set     (t_strchr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_indexed_set    (t_strchr *x, void *attr, long argc, t_atom *argv);
 
 
 /****************************************************************
@@ -112,6 +185,60 @@ void ext_main(void *r)
   CLASS_ATTR_SELFSAVE(c, "fprecision", 0);
   CLASS_ATTR_ACCESSORS(c, "fprecision", NULL, str_fprecision_set);
 
+  CLASS_ATTR_LONG(c, "from", 0, t_strchr, from);
+  CLASS_ATTR_ORDER(c, "from", 0, "3");
+  CLASS_ATTR_LABEL(c, "from", 0, "start offset");
+  CLASS_ATTR_FILTER_MIN(c, "from", 0);
+  CLASS_ATTR_SAVE(c, "from", 0);
+  CLASS_ATTR_SELFSAVE(c, "from", 0);
+  CLASS_ATTR_ACCESSORS(c, "from", NULL, str_from_set);
+
+  CLASS_ATTR_LONG(c, "reverse", 0, t_strchr, reverse);
+  CLASS_ATTR_ORDER(c, "reverse", 0, "4");
+  CLASS_ATTR_LABEL(c, "reverse", 0, "search from the end");
+  CLASS_ATTR_FILTER_CLIP(c, "reverse", 0, 1);
+  CLASS_ATTR_SAVE(c, "reverse", 0);
+  CLASS_ATTR_SELFSAVE(c, "reverse", 0);
+  CLASS_ATTR_ACCESSORS(c, "reverse", NULL, str_reverse_set);
+
+  CLASS_ATTR_LONG(c, "nth", 0, t_strchr, nth);
+  CLASS_ATTR_ORDER(c, "nth", 0, "5");
+  CLASS_ATTR_LABEL(c, "nth", 0, "occurrence");
+  CLASS_ATTR_FILTER_MIN(c, "nth", 1);
+  CLASS_ATTR_SAVE(c, "nth", 0);
+  CLASS_ATTR_SELFSAVE(c, "nth", 0);
+  CLASS_ATTR_ACCESSORS(c, "nth", NULL, str_nth_set);
+
+  CLASS_ATTR_LONG(c, "charset", 0, t_strchr, charset);
+  CLASS_ATTR_ORDER(c, "charset", 0, "6");
+  CLASS_ATTR_LABEL(c, "charset", 0, "character, set or complement");
+  CLASS_ATTR_FILTER_CLIP(c, "charset", 0, 2);
+  CLASS_ATTR_SAVE(c, "charset", 0);
+  CLASS_ATTR_SELFSAVE(c, "charset", 0);
+  CLASS_ATTR_ACCESSORS(c, "charset", NULL, str_charset_set);
+
+  CLASS_ATTR_LONG(c, "report", 0, t_strchr, report);
+  CLASS_ATTR_ORDER(c, "report", 0, "7");
+  CLASS_ATTR_LABEL(c, "report", 0, "report first, all or count");
+  CLASS_ATTR_FILTER_CLIP(c, "report", 0, 2);
+  CLASS_ATTR_SAVE(c, "report", 0);
+  CLASS_ATTR_SELFSAVE(c, "report", 0);
+  CLASS_ATTR_ACCESSORS(c, "report", NULL, str_report_set);
+
+  CLASS_ATTR_LONG(c, "indexed", 0, t_strchr, indexed);
+  CLASS_ATTR_ORDER(c, "indexed", 0, "8");
+  CLASS_ATTR_LABEL(c, "indexed", 0, "index the string");
+  CLASS_ATTR_FILTER_CLIP(c, "indexed", 0, 1);
+  CLASS_ATTR_SAVE(c, "indexed", 0);
+  CLASS_ATTR_SELFSAVE(c, "indexed", 0);
+  CLASS_ATTR_ACCESSORS(c, "indexed", NULL, str_indexed_set);
+
+#ifdef STR_SSE2
+  int info[4];
+  __cpuid(info, 1);
+  str_ssse3 = (info[2] >> 9) & 1;   // ECX bit 9
+#endif
+
   class_register(CLASS_BOX, c);
   strchr_class = c;
 }
@@ -133,7 +260,7 @@ void *strchr_new(t_symbol *sym, long argc, t_atom *argv)
   // Set inlets, outlets, and proxy
   x->inl_proxy_ind = 0;
   x->inl_proxy = proxy_new((t_object *)x, 1, &x->inl_proxy_ind);
-  x->outl_int = intout((t_object *)x);
+  x->outl_any = outlet_new((t_object *)x, NULL);
 
   // Set the left string buffer
   x->i_dstr1 = dstr_new();
@@ -144,13 +271,21 @@ void *strchr_new(t_symbol *sym, long argc, t_atom *argv)
     x->i_dstr2 = str_cat_atom(x, x->i_dstr2, argv);
   }
 
+  // Set the array of positions
+  x->o_pos_max = STR_POS_ALLOC;
+  x->o_pos_arr = (t_atom *)sysmem_newptr(sizeof(t_atom) * x->o_pos_max);
+
   // Test the string buffers
-  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2) || !x->o_pos_arr) {
     object_error((t_object *)x, "Allocation error.");
     strchr_free(x);
     return NULL;
   }
 
+  // The set is compiled, and the string indexed, on the first search
+  x->s_dirty = 1;
+  x->ix_dirty = 1;
+
   // Second argument:  mode
   long mode = 0;
   if ((argc >= 2) && (attr_args_offset((short)argc, argv) >= 2)) {
@@ -165,8 +300,13 @@ void *strchr_new(t_symbol *sym, long argc, t_atom *argv)
   // Set the float precision
   object_attr_setlong(x, gensym("fprecision"), 6);
 
+  // Report the first occurrence
+  object_attr_setlong(x, gensym("nth"), 1);
+
   // Set the remaining variables
   x->o_pos = -1;
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
 
   // Process the attributes
   attr_args_process(x, (short)argc, argv);
@@ -181,6 +321,8 @@ void strchr_free(t_strchr *x)
 {
   dstr_free(&x->i_dstr1);
   dstr_free(&x->i_dstr2);
+  if (x->o_pos_arr) { sysmem_freeptr(x->o_pos_arr); }
+  if (x->ix_pos) { sysmem_freeptr(x->ix_pos); }
   freeobject((t_object *)x->inl_proxy);
 }
 
@@ -200,8 +342,8 @@ void strchr_assist(t_strchr *x, void *b, long msg, long arg, char *dst)
   case ASSIST_OUTLET:
     switch (arg) {
     case 0:
-      if (x->mode == 0) { sprintf(dst, "position of s2 in s1 (int)"); }
-      else { sprintf(dst, "position of s1 in s2 (int)"); }
+      if (x->mode == 0) { sprintf(dst, "position of s2 in s1 (int / list)"); }
+      else { sprintf(dst, "position of s1 in s2 (int / list)"); }
       break;
     default: break;
     }
@@ -225,8 +367,7 @@ void strchr_int(t_strchr *x, long n)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_int(dstr, n);
-  strchr_action(x);
-  if (dstr == x->i_dstr1) { strchr_output(x); }
+  strchr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -237,8 +378,7 @@ void strchr_float(t_strchr *x, double f)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_printf(dstr, x->format, f);
-  strchr_action(x);
-  if (dstr == x->i_dstr1) { strchr_output(x); }
+  strchr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -250,8 +390,7 @@ void strchr_list(t_strchr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strchr_action(x);
-  if (dstr == x->i_dstr1) { strchr_output(x); }
+  strchr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -263,8 +402,7 @@ void strchr_anything(t_strchr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_cpy_cstr(dstr, sym->s_name);
   str_cat_args(x, dstr, argc, argv);
-  strchr_action(x);
-  if (dstr == x->i_dstr1) { strchr_output(x); }
+  strchr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -276,7 +414,7 @@ void strchr_set(t_strchr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strchr_action(x);
+  strchr_input(x, dstr, 0);
 }
 
 /****************************************************************
@@ -286,12 +424,31 @@ void strchr_post(t_strchr *x)
 {
   object_post((t_object *)x, "Mode:  %i", x->mode);
   object_post((t_object *)x, "Float precision:  %i", x->fprecision);
+  object_post((t_object *)x, "From:  %i - Reverse: %i - Nth: %i", x->from, x->reverse, x->nth);
+  object_post((t_object *)x, "Charset:  %i - SSSE3: %i", x->charset, str_ssse3);
+  object_post((t_object *)x, "Report:  %i - Matches: %i - Alloc: %i", x->report, x->o_cnt, x->o_pos_max);
+  object_post((t_object *)x, "Indexed:  %i - Alloc: %i", x->indexed, x->ix_max);
   object_post((t_object *)x, "Alloc:  Left: %i - Right: %i",
     DSTR_ALLOC(x->i_dstr1), DSTR_ALLOC(x->i_dstr2));
   object_post((t_object *)x, "Left: %s", DSTR_CSTR(x->i_dstr1));
   object_post((t_object *)x, "Right: %s", DSTR_CSTR(x->i_dstr2));
 }
 
+/****************************************************************
+*  Process a new input, invalidating the set or the index of the modified string
+*
+*  @param dstr The string buffer that was just modified.
+*  @param output Whether the input should trigger an output.
+*/
+void strchr_input(t_strchr *x, t_dstr dstr, char output)
+{
+  if (dstr == ((x->mode == 0) ? x->i_dstr2 : x->i_dstr1)) { x->s_dirty = 1; }
+  else { x->ix_dirty = 1; }
+
+  strchr_action(x);
+  if (output && (dstr == x->i_dstr1)) { strchr_output(x); }
+}
+
 /****************************************************************
 *  The specific string action
 */
@@ -300,18 +457,266 @@ void strchr_action(t_strchr *x)
   // Test that the t_dstr strings are not NULL
   if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
     x->o_pos = -1;
+    x->o_cnt = 0;
+    x->o_pos_cnt = 0;
     object_error((t_object *)x, "Allocation error. Reset the external.");
     return;
   }
 
-  char *cp;
-  if (x->mode == 0) {
-    cp = memchr(DSTR_CSTR(x->i_dstr1), DSTR_CSTR(x->i_dstr2)[0], DSTR_LENGTH(x->i_dstr1));
-    x->o_pos = cp ? (long)(cp - DSTR_CSTR(x->i_dstr1) + 1) : -1;
+  t_dstr hay = (x->mode == 0) ? x->i_dstr1 : x->i_dstr2;
+  t_dstr ndl = (x->mode == 0) ? x->i_dstr2 : x->i_dstr1;
 
-  } else if (x->mode == 1) {
-    cp = memchr(DSTR_CSTR(x->i_dstr2), DSTR_CSTR(x->i_dstr1)[0], DSTR_LENGTH(x->i_dstr2));
-    x->o_pos = cp ? (long)(cp - DSTR_CSTR(x->i_dstr2) + 1) : -1;
+  if (x->s_dirty) { strchr_prepare(x, ndl); }
+
+  char c = DSTR_CSTR(ndl)[0];
+  const char *str = DSTR_CSTR(hay);
+  t_dstr_int len = DSTR_LENGTH(hay);
+  t_dstr_int off = ((t_dstr_int)x->from < len) ? (t_dstr_int)x->from : len;
+  t_dstr_int pos = DSTR_LEN_ERR;
+
+  x->o_pos = -1;
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
+
+  // Without the index, because of an allocation error, fall back to the scan
+  if (x->indexed && !x->charset) {
+    if (x->ix_dirty) { strchr_index(x, hay); }
+    if (x->ix_pos) {
+      if (!x->reverse) { strchr_query(x, (unsigned char)c, off, len); }
+      else { strchr_query(x, (unsigned char)c, 0, len - off); }
+      return;
+    }
+  }
+
+  if (x->report) {
+    if (!x->reverse) { strchr_scan(x, str, off, len, c); }
+    else { strchr_scan(x, str, 0, len - off, c); }
+    return;
+  }
+
+  if (!x->reverse) {
+    t_dstr_int beg = off;
+
+    for (long i = 0; i < x->nth; i++) {
+      pos = strchr_find(x, str + beg, len - beg, c);
+      if (pos == DSTR_LEN_ERR) { return; }
+      pos += beg;
+      beg = pos + 1;
+    }
+
+  } else {
+    t_dstr_int lim = len - off;
+
+    for (long i = 0; i < x->nth; i++) {
+      pos = strchr_rfind(x, str, lim, c);
+      if (pos == DSTR_LEN_ERR) { return; }
+      lim = pos;
+    }
+  }
+
+  x->o_pos = (long)(pos + 1);
+}
+
+/****************************************************************
+*  Compile the searched string into a set of characters
+*
+*  The bitmap is complemented for charset 2.  The nibble tables give,
+*  for each low nibble, the bitmask of the high nibbles in the set.
+*/
+void strchr_prepare(t_strchr *x, t_dstr set)
+{
+  const unsigned char *str = (const unsigned char *)DSTR_CSTR(set);
+  t_dstr_int len = DSTR_LENGTH(set);
+
+  memset(x->s_map, 0, sizeof(x->s_map));
+  for (t_dstr_int i = 0; i < len; i++) { x->s_map[str[i] >> 3] |= 1 << (str[i] & 7); }
+
+  if (x->charset == 2) {
+    for (int i = 0; i < 32; i++) { x->s_map[i] = ~x->s_map[i]; }
+  }
+
+  memset(x->s_nib, 0, sizeof(x->s_nib));
+  for (int c = 0; c < 256; c++) {
+    if (STR_MAP_TEST(x->s_map, c)) { x->s_nib[c >> 7][c & 15] |= 1 << ((c >> 4) & 7); }
+  }
+
+  x->s_dirty = 0;
+}
+
+/****************************************************************
+*  Find the first occurrence of the character, or of a character of the set
+*
+*  @return The 0-based position of the occurrence, or DSTR_LEN_ERR.
+*/
+t_dstr_int strchr_find(t_strchr *x, const char *str, t_dstr_int len, char c)
+{
+  if (x->charset) { return str_set_find(x, str, len); }
+
+  const char *cp = (const char *)memchr(str, c, len);
+  return cp ? (t_dstr_int)(cp - str) : DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Find the last occurrence of the character, or of a character of the set
+*
+*  @return The 0-based position of the occurrence, or DSTR_LEN_ERR.
+*/
+t_dstr_int strchr_rfind(t_strchr *x, const char *str, t_dstr_int len, char c)
+{
+  if (x->charset) { return str_set_rfind(x, str, len); }
+  return str_memrchr(str, c, len);
+}
+
+/****************************************************************
+*  Find all the occurrences between two positions, for the all and count reports
+*
+*  With SSE2, 32 characters are compared per iteration.  For the positions,
+*  the two comparison masks are joined into a 32-bit bitmask, scanned with
+*  _BitScanForward().  For the count, the comparisons are accumulated in byte
+*  counters, summed with _mm_sad_epu8() before they overflow.
+*/
+void strchr_scan(t_strchr *x, const char *str, t_dstr_int beg, t_dstr_int end, char c)
+{
+  const unsigned char *s = (const unsigned char *)str;
+  t_dstr_int i = beg;
+
+#ifdef STR_SSE2
+  if (!x->charset || str_ssse3) {
+    __m128i c_16 = _mm_set1_epi8(c);
+    __m128i nib_low = _mm_loadu_si128((const __m128i *)x->s_nib[0]);
+    __m128i nib_high = _mm_loadu_si128((const __m128i *)x->s_nib[1]);
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    __m128i sum = zero;
+    __m128i eq_1;
+    __m128i eq_2;
+    long blk = 0;
+    unsigned long mask;
+    unsigned long bit;
+
+    for (; i + 32 <= end; i += 32) {
+      if (x->charset) {
+        eq_1 = str_set_cmp(_mm_loadu_si128((const __m128i *)(str + i)), nib_low, nib_high);
+        eq_2 = str_set_cmp(_mm_loadu_si128((const __m128i *)(str + i + 16)), nib_low, nib_high);
+      } else {
+        eq_1 = _mm_cmpeq_epi8(c_16, _mm_loadu_si128((const __m128i *)(str + i)));
+        eq_2 = _mm_cmpeq_epi8(c_16, _mm_loadu_si128((const __m128i *)(str + i + 16)));
+      }
+
+      if (x->report == 2) {
+        // Each comparison adds 0 or 1 to the byte counters:  at most 254 after 127 iterations
+        acc = _mm_sub_epi8(_mm_sub_epi8(acc, eq_1), eq_2);
+        if (++blk == 127) {
+          sum = _mm_add_epi64(sum, _mm_sad_epu8(acc, zero));
+          acc = zero;
+          blk = 0;
+        }
+
+      } else {
+        mask = (unsigned long)_mm_movemask_epi8(eq_1) | ((unsigned long)_mm_movemask_epi8(eq_2) << 16);
+        while (mask) {
+          _BitScanForward(&bit, mask);
+          x->o_cnt++;
+          strchr_add(x, (t_atom_long)(i + bit) + 1);
+          mask &= mask - 1;
+        }
+      }
+    }
+
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(acc, zero));
+    x->o_cnt += _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  }
+#endif
+
+  // Remaining characters
+  for (; i < end; i++) {
+    if (x->charset ? !STR_MAP_TEST(x->s_map, s[i]) : (str[i] != c)) { continue; }
+    x->o_cnt++;
+    if (x->report == 1) { strchr_add(x, (t_atom_long)i + 1); }
+  }
+}
+
+/****************************************************************
+*  Store an int for output, growing the array if necessary
+*/
+void strchr_add(t_strchr *x, t_atom_long n)
+{
+  if (x->o_pos_cnt == STR_POS_MAX) { return; }
+
+  if (x->o_pos_cnt == x->o_pos_max) {
+    short max = (x->o_pos_max < STR_POS_MAX / 2) ? 2 * x->o_pos_max : STR_POS_MAX;
+    t_atom *arr = (t_atom *)sysmem_resizeptr(x->o_pos_arr, sizeof(t_atom) * max);
+    if (!arr) { return; }
+    x->o_pos_arr = arr;
+    x->o_pos_max = max;
+  }
+
+  atom_setlong(x->o_pos_arr + x->o_pos_cnt++, n);
+}
+
+/****************************************************************
+*  Index the positions of the characters of the string
+*
+*  The positions are sorted by character with a counting sort, so that
+*  the positions of each character are contiguous and increasing.
+*/
+void strchr_index(t_strchr *x, t_dstr hay)
+{
+  const unsigned char *str = (const unsigned char *)DSTR_CSTR(hay);
+  t_dstr_int len = DSTR_LENGTH(hay);
+  t_dstr_int next[256];
+
+  if (!x->ix_pos || (len > x->ix_max)) {
+    t_dstr_int max = (len > STR_POS_ALLOC) ? len : STR_POS_ALLOC;
+    t_dstr_int *arr = x->ix_pos
+      ? (t_dstr_int *)sysmem_resizeptr(x->ix_pos, sizeof(t_dstr_int) * max)
+      : (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * max);
+
+    if (!arr) {
+      object_error((t_object *)x, "indexed:  Allocation error.");
+      if (x->ix_pos) { sysmem_freeptr(x->ix_pos); }
+      x->ix_pos = NULL;
+      x->ix_max = 0;
+      return;
+    }
+
+    x->ix_pos = arr;
+    x->ix_max = max;
+  }
+
+  memset(x->ix_start, 0, sizeof(x->ix_start));
+  for (t_dstr_int i = 0; i < len; i++) { x->ix_start[str[i] + 1]++; }
+  for (int c = 0; c < 256; c++) { x->ix_start[c + 1] += x->ix_start[c]; }
+
+  memcpy(next, x->ix_start, sizeof(next));
+  for (t_dstr_int i = 0; i < len; i++) { x->ix_pos[next[str[i]]++] = i; }
+
+  x->ix_dirty = 0;
+}
+
+/****************************************************************
+*  Answer a query for a character between two positions from the index
+*/
+void strchr_query(t_strchr *x, unsigned char c, t_dstr_int beg, t_dstr_int end)
+{
+  const t_dstr_int *pos = x->ix_pos + x->ix_start[c];
+  t_dstr_int cnt = x->ix_start[c + 1] - x->ix_start[c];
+  t_dstr_int lo = str_lower_bound(pos, cnt, beg);
+  t_dstr_int hi = str_lower_bound(pos, cnt, end);
+
+  switch (x->report) {
+  case 0:
+    if ((t_dstr_int)x->nth > hi - lo) { break; }
+    x->o_pos = (long)(x->reverse ? pos[hi - x->nth] : pos[lo + x->nth - 1]) + 1;
+    break;
+  case 1:
+    for (t_dstr_int i = lo; i < hi; i++) { strchr_add(x, (t_atom_long)pos[i] + 1); }
+    x->o_cnt = (long)(hi - lo);
+    break;
+  case 2:
+    x->o_cnt = (long)(hi - lo);
+    break;
+  default: break;
   }
 }
 
@@ -320,8 +725,164 @@ void strchr_action(t_strchr *x)
 */
 void strchr_output(t_strchr *x)
 {
-  outlet_int(x->outl_int, x->o_pos);
+  switch (x->report) {
+  case 0: outlet_int(x->outl_any, x->o_pos); break;
+  case 1:
+    if (x->o_pos_cnt) { outlet_list(x->outl_any, NULL, x->o_pos_cnt, x->o_pos_arr); }
+    else { outlet_int(x->outl_any, -1); }
+    break;
+  case 2: outlet_int(x->outl_any, x->o_cnt); break;
+  default: break;
+  }
+}
+
+/****************************************************************
+*  Search backwards for a character, as memrchr() which is not in the CRT
+*
+*  With SSE2, 16 characters are compared at a time from the end, and
+*  the highest bit of the mask gives the last occurrence.
+*
+*  @return The 0-based position of the last occurrence, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_memrchr(const char *str, char c, t_dstr_int len)
+{
+#ifdef STR_SSE2
+  __m128i c_16 = _mm_set1_epi8(c);
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; len >= 16; len -= 16) {
+    mask = (unsigned long)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(c_16, _mm_loadu_si128((const __m128i *)(str + len - 16))));
+    if (mask) {
+      _BitScanReverse(&bit, mask);
+      return len - 16 + bit;
+    }
+  }
+#endif
+
+  while (len > 0) {
+    if (str[--len] == c) { return len; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Find the first character of a string that is in the set
+*
+*  @return The 0-based position of the character, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_set_find(t_strchr *x, const char *str, t_dstr_int len)
+{
+  const unsigned char *s = (const unsigned char *)str;
+  t_dstr_int i = 0;
+
+#ifdef STR_SSE2
+  if (str_ssse3) {
+    __m128i nib_low = _mm_loadu_si128((const __m128i *)x->s_nib[0]);
+    __m128i nib_high = _mm_loadu_si128((const __m128i *)x->s_nib[1]);
+    unsigned long mask;
+    unsigned long bit;
+
+    for (; i + 16 <= len; i += 16) {
+      mask = (unsigned long)_mm_movemask_epi8(
+        str_set_cmp(_mm_loadu_si128((const __m128i *)(str + i)), nib_low, nib_high));
+      if (mask) {
+        _BitScanForward(&bit, mask);
+        return i + bit;
+      }
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    if (STR_MAP_TEST(x->s_map, s[i])) { return i; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Binary search in an array of increasing positions
+*
+*  @return The index of the first position not less than the value.
+*/
+t_dstr_int str_lower_bound(const t_dstr_int *arr, t_dstr_int cnt, t_dstr_int val)
+{
+  t_dstr_int lo = 0;
+  t_dstr_int hi = cnt;
+  t_dstr_int mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (arr[mid] < val) { lo = mid + 1; } else { hi = mid; }
+  }
+
+  return lo;
+}
+
+/****************************************************************
+*  Find the last character of a string that is in the set
+*
+*  @return The 0-based position of the character, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_set_rfind(t_strchr *x, const char *str, t_dstr_int len)
+{
+  const unsigned char *s = (const unsigned char *)str;
+
+#ifdef STR_SSE2
+  if (str_ssse3) {
+    __m128i nib_low = _mm_loadu_si128((const __m128i *)x->s_nib[0]);
+    __m128i nib_high = _mm_loadu_si128((const __m128i *)x->s_nib[1]);
+    unsigned long mask;
+    unsigned long bit;
+
+    for (; len >= 16; len -= 16) {
+      mask = (unsigned long)_mm_movemask_epi8(
+        str_set_cmp(_mm_loadu_si128((const __m128i *)(str + len - 16)), nib_low, nib_high));
+      if (mask) {
+        _BitScanReverse(&bit, mask);
+        return len - 16 + bit;
+      }
+    }
+  }
+#endif
+
+  while (len > 0) {
+    len--;
+    if (STR_MAP_TEST(x->s_map, s[len])) { return len; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+#ifdef STR_SSE2
+/****************************************************************
+*  Classify 16 characters with the nibble tables of the set
+*
+*  The low nibble selects the bitmask of the high nibbles in the set,
+*  from the table for bytes below or above 0x80, and the high nibble
+*  selects the bit to test.  Uses SSSE3, for _mm_shuffle_epi8().
+*
+*  @return 0xFF for the characters in the set, 0 for the others.
+*/
+__m128i str_set_cmp(__m128i v, __m128i nib_low, __m128i nib_high)
+{
+  __m128i low_4 = _mm_set1_epi8(0x0F);
+  __m128i lo = _mm_and_si128(v, low_4);
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low_4);
+  __m128i is_high = _mm_cmplt_epi8(v, _mm_setzero_si128());
+
+  __m128i row = _mm_or_si128(
+    _mm_andnot_si128(is_high, _mm_shuffle_epi8(nib_low, lo)),
+    _mm_and_si128(is_high, _mm_shuffle_epi8(nib_high, lo)));
+  __m128i bit = _mm_shuffle_epi8(
+    _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128), hi);
+
+  return _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
 }
+#endif
 
 /****************************************************************
 *  Get the destination buffer depending on the proxy
@@ -369,6 +930,8 @@ t_max_err str_mode_set(t_strchr *x, void *attr, long argc, t_atom *argv)
 {
   if (argc && argv) { x->mode = (long)atom_getlong(argv); } else { x->mode = 0; }
 
+  x->s_dirty = 1;
+  x->ix_dirty = 1;
   strchr_action(x);
   return MAX_ERR_NONE;
 }
@@ -386,3 +949,70 @@ t_max_err str_fprecision_set(t_strchr *x, void *attr, long argc, t_atom *argv)
 
   return MAX_ERR_NONE;
 }
+
+/****************************************************************
+*  Custom setter for the start offset attribute
+*/
+t_max_err str_from_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->from = (long)atom_getlong(argv); } else { x->from = 0; }
+
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the reverse attribute
+*/
+t_max_err str_reverse_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->reverse = (long)atom_getlong(argv); } else { x->reverse = 0; }
+
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the nth attribute
+*/
+t_max_err str_nth_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->nth = (long)atom_getlong(argv); } else { x->nth = 1; }
+
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the charset attribute
+*/
+t_max_err str_charset_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->charset = (long)atom_getlong(argv); } else { x->charset = 0; }
+
+  x->s_dirty = 1;
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the report attribute
+*/
+t_max_err str_report_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->report = (long)atom_getlong(argv); } else { x->report = 0; }
+
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the indexed attribute
+*/
+t_max_err str_indexed_set(t_strchr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->indexed = (long)atom_getlong(argv); } else { x->indexed = 0; }
+
+  strchr_action(x);
+  return MAX_ERR_NONE;
+}
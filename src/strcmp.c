@@ -8,6 +8,48 @@
 *    - the new style Max object,
 *    - dynamic strings,
 *    - attributes.
+*
+*  The comparison uses the string lengths, and is binary safe.  When a string
+*  was set from a single symbol, the symbol is kept:  symbols are unique for
+*  each string, so that two strings set from the same symbol are equal
+*  without being compared, and a repeated symbol is not copied again.
+*
+*  Case insensitive comparison (icase 1):  ASCII letters are folded to lower
+*  case while comparing, 16 characters at a time with SSE2, without copying
+*  the strings.  With icase 2, the Latin-1 letters encoded in UTF-8
+*  (U+00C0 to U+00DE) are also folded.
+*
+*  Natural comparison (natural 1):  runs of digits are compared by their
+*  numerical value, so that "file9" comes before "file10".  For equal values,
+*  the run with fewer leading zeros comes first.
+*
+*  The common attribute sends the length of the common prefix of the strings
+*  (1), or the lengths of the common prefix and suffix (2), from the right
+*  outlet.  The suffix is searched in what remains after the prefix, and
+*  with icase only ASCII letters are folded.  Both are computed 32 characters
+*  at a time with SSE2.
+*
+*  With the distance attribute, the middle outlet sends the edit distance
+*  (Levenshtein, on bytes) instead of the comparison.  The common prefix and
+*  suffix are skipped, then the distance is computed with the bit-parallel
+*  algorithm of Myers, over the shorter string in as many 64-bit words as
+*  needed.  With maxdist, the computation stops as soon as the distance is
+*  known to be larger, and -1 is sent.  With icase, ASCII letters are folded.
+*
+*  Dictionary lookup (dict 1):  the right string is a list of entries
+*  separated by spaces, compiled into a trie with a transition table over the
+*  classes of the bytes used, and rebuilt only when it changes.  The middle
+*  outlet sends the 0-based index of the entry equal to the left string, or
+*  -1, after a single pass over it.  With dict 2, the index is the one of the
+*  longest entry that is a prefix of the left string.  If an entry is
+*  repeated, the first index is sent.  With mode 1, the sides are swapped:
+*  the list is the left string, and the right string is looked up in it.
+*
+*  Locale collation (collate 1):  the strings are compared by their sort keys
+*  in the user locale with UTF-8, computed with _strxfrm_l() only when a
+*  string changes, and kept alongside it, so that each comparison is a
+*  memcmp() of the keys.  The keys stop at the first null character.  The
+*  collation takes precedence over icase and natural.
 */
 
 /****************************************************************
@@ -16,10 +58,18 @@
 #include "ext.h"
 #include "ext_obex.h"
 #include "dstring.h"
+#include <limits.h>
+#include <locale.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STR_SSE2 1
+#include <intrin.h>
+#endif
 
 /****************************************************************
 *  Preprocessor
 */
+#define STR_IS_DIGIT(c) (((c) >= '0') && ((c) <= '9'))
 
 /****************************************************************
 *  Max object structure
@@ -32,13 +82,41 @@ typedef struct _strcmp
   long  inl_proxy_ind;
   void *outl_int1;
   void *outl_int2;
+  void *outl_any;
 
-  t_dstr i_dstr1;
-  t_dstr i_dstr2;
+  t_dstr     i_dstr1;
+  t_dstr     i_dstr2;
+  t_symbol  *i_sym1;      // symbol of the left string, or NULL
+  t_symbol  *i_sym2;      // symbol of the right string, or NULL
+  t_dstr     k_dstr1;     // sort key of the left string
+  t_dstr     k_dstr2;     // sort key of the right string
+  char       k_dirty1;
+  char       k_dirty2;
   long   o_int1;
   long   o_int2;
+  long   o_prefix;
+  long   o_suffix;
+
+  long              d_blk_max;
+  unsigned __int64 *d_peq;      // match bitmasks of each byte, 256 * d_blk_max, kept cleared
+  unsigned __int64 *d_vp;       // positive vertical deltas, d_blk_max
+  unsigned __int64 *d_vn;       // negative vertical deltas, d_blk_max
+
+  long   tr_cls[256];     // byte to character class
+  long   tr_cls_cnt;
+  long   tr_state_cnt;
+  long  *tr_next;         // transitions, tr_state_cnt * tr_cls_cnt, 0 for none
+  long  *tr_ent;          // 1-based entry index ending at a state, or 0
+  char   tr_dirty;
 
   long  mode;
+  long  icase;
+  long  natural;
+  long  common;
+  long  distance;
+  long  maxdist;
+  long  dict;
+  long  collate;
   long  fprecision;
   char  format[6];
 
@@ -49,6 +127,16 @@ typedef struct _strcmp
 */
 static t_class *strcmp_class = NULL;
 
+/****************************************************************
+*  Global ASCII folding table
+*/
+static unsigned char str_fold[256];
+
+/****************************************************************
+*  Global collation locale, or NULL
+*/
+static _locale_t str_locale = NULL;
+
 /****************************************************************
 *  Function declarations
 */
@@ -64,14 +152,38 @@ void  strcmp_anything (t_strcmp *x, t_symbol *sym, long argc, t_atom *argv);
 void  strcmp_set      (t_strcmp *x, t_symbol *sym, long argc, t_atom *argv);
 void  strcmp_post     (t_strcmp *x);
 
+void  strcmp_input    (t_strcmp *x, t_dstr dstr, t_symbol *sym, char output);
 void  strcmp_action   (t_strcmp *x);
+void  strcmp_common   (t_strcmp *x);
+long  strcmp_distance (t_strcmp *x);
+void  strcmp_dict     (t_strcmp *x);
+void  strcmp_tr_build (t_strcmp *x);
+void  strcmp_tr_free  (t_strcmp *x);
+void  strcmp_keys     (t_strcmp *x);
 void  strcmp_output   (t_strcmp *x);
 
+int       str_compare        (const char *str1, t_dstr_int len1, const char *str2, t_dstr_int len2, long icase, long natural);
+int       str_natural        (const unsigned char *s1, t_dstr_int len1, const unsigned char *s2, t_dstr_int len2, t_dstr_int i, long icase);
+t_dstr_int str_mismatch      (const char *str1, const char *str2, t_dstr_int len, long icase);
+t_dstr_int str_rmismatch     (const char *end1, const char *end2, t_dstr_int len, long icase);
+long      str_myers_advance  (unsigned __int64 *vp, unsigned __int64 *vn, const unsigned __int64 *eq, long blk_cnt, unsigned __int64 last, long hin);
+unsigned char str_fold_at    (const unsigned char *str, t_dstr_int i, long icase);
+#ifdef STR_SSE2
+__m128i   str_fold_sse2      (__m128i v);
+#endif
+t_dstr    str_xfrm           (t_dstr key, t_dstr src);
 t_dstr    str_proxy_to_dstr  (t_strcmp *x);
 t_dstr    str_cat_atom       (t_strcmp *x, t_dstr dstr, t_atom *atom);
 t_dstr    str_cat_args       (t_strcmp *x, t_dstr dstr, long argc, t_atom *argv);
 t_max_err str_mode_set       (t_strcmp *x, void *attr, long argc, t_atom *argv);
 t_max_err str_fprecision_set (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_icase_set      (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_natural_set    (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_common_set     (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_distance_set   (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_maxdist_set    (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_dict_set       (t_strcmp *x, void *attr, long argc, t_atom *argv);
+t_max_err str_collate_set    (t_strcmp *x, void *attr, long argc, t_atom *argv);
 
 
 /****************************************************************
@@ -114,6 +226,68 @@ void ext_main(void *r)
   CLASS_ATTR_SELFSAVE(c, "fprecision", 0);
   CLASS_ATTR_ACCESSORS(c, "fprecision", NULL, str_fprecision_set);
 
+  CLASS_ATTR_LONG(c, "icase", 0, t_strcmp, icase);
+  CLASS_ATTR_ORDER(c, "icase", 0, "3");
+  CLASS_ATTR_LABEL(c, "icase", 0, "ignore case");
+  CLASS_ATTR_FILTER_CLIP(c, "icase", 0, 2);
+  CLASS_ATTR_SAVE(c, "icase", 0);
+  CLASS_ATTR_SELFSAVE(c, "icase", 0);
+  CLASS_ATTR_ACCESSORS(c, "icase", NULL, str_icase_set);
+
+  CLASS_ATTR_LONG(c, "natural", 0, t_strcmp, natural);
+  CLASS_ATTR_ORDER(c, "natural", 0, "4");
+  CLASS_ATTR_LABEL(c, "natural", 0, "natural order");
+  CLASS_ATTR_FILTER_CLIP(c, "natural", 0, 1);
+  CLASS_ATTR_SAVE(c, "natural", 0);
+  CLASS_ATTR_SELFSAVE(c, "natural", 0);
+  CLASS_ATTR_ACCESSORS(c, "natural", NULL, str_natural_set);
+
+  CLASS_ATTR_LONG(c, "common", 0, t_strcmp, common);
+  CLASS_ATTR_ORDER(c, "common", 0, "5");
+  CLASS_ATTR_LABEL(c, "common", 0, "common prefix and suffix");
+  CLASS_ATTR_FILTER_CLIP(c, "common", 0, 2);
+  CLASS_ATTR_SAVE(c, "common", 0);
+  CLASS_ATTR_SELFSAVE(c, "common", 0);
+  CLASS_ATTR_ACCESSORS(c, "common", NULL, str_common_set);
+
+  CLASS_ATTR_LONG(c, "distance", 0, t_strcmp, distance);
+  CLASS_ATTR_ORDER(c, "distance", 0, "6");
+  CLASS_ATTR_LABEL(c, "distance", 0, "edit distance");
+  CLASS_ATTR_FILTER_CLIP(c, "distance", 0, 1);
+  CLASS_ATTR_SAVE(c, "distance", 0);
+  CLASS_ATTR_SELFSAVE(c, "distance", 0);
+  CLASS_ATTR_ACCESSORS(c, "distance", NULL, str_distance_set);
+
+  CLASS_ATTR_LONG(c, "maxdist", 0, t_strcmp, maxdist);
+  CLASS_ATTR_ORDER(c, "maxdist", 0, "7");
+  CLASS_ATTR_LABEL(c, "maxdist", 0, "maximum edit distance");
+  CLASS_ATTR_FILTER_MIN(c, "maxdist", -1);
+  CLASS_ATTR_SAVE(c, "maxdist", 0);
+  CLASS_ATTR_SELFSAVE(c, "maxdist", 0);
+  CLASS_ATTR_ACCESSORS(c, "maxdist", NULL, str_maxdist_set);
+
+  CLASS_ATTR_LONG(c, "dict", 0, t_strcmp, dict);
+  CLASS_ATTR_ORDER(c, "dict", 0, "8");
+  CLASS_ATTR_LABEL(c, "dict", 0, "dictionary lookup");
+  CLASS_ATTR_FILTER_CLIP(c, "dict", 0, 2);
+  CLASS_ATTR_SAVE(c, "dict", 0);
+  CLASS_ATTR_SELFSAVE(c, "dict", 0);
+  CLASS_ATTR_ACCESSORS(c, "dict", NULL, str_dict_set);
+
+  CLASS_ATTR_LONG(c, "collate", 0, t_strcmp, collate);
+  CLASS_ATTR_ORDER(c, "collate", 0, "9");
+  CLASS_ATTR_LABEL(c, "collate", 0, "locale collation");
+  CLASS_ATTR_FILTER_CLIP(c, "collate", 0, 1);
+  CLASS_ATTR_SAVE(c, "collate", 0);
+  CLASS_ATTR_SELFSAVE(c, "collate", 0);
+  CLASS_ATTR_ACCESSORS(c, "collate", NULL, str_collate_set);
+
+  for (int c = 0; c < 256; c++) { str_fold[c] = ((c >= 'A') && (c <= 'Z')) ? (unsigned char)(c + 0x20) : (unsigned char)c; }
+
+  // The user locale with UTF-8, or with its code page
+  str_locale = _create_locale(LC_COLLATE, ".UTF-8");
+  if (!str_locale) { str_locale = _create_locale(LC_COLLATE, ""); }
+
   class_register(CLASS_BOX, c);
   strcmp_class = c;
 }
@@ -135,6 +309,7 @@ void *strcmp_new(t_symbol *sym, long argc, t_atom *argv)
   // Set inlets, outlets, and proxy
   x->inl_proxy_ind = 0;
   x->inl_proxy = proxy_new((t_object *)x, 1, &x->inl_proxy_ind);
+  x->outl_any = outlet_new((t_object *)x, NULL);
   x->outl_int2 = intout((t_object *)x);
   x->outl_int1 = intout((t_object *)x);
 
@@ -143,12 +318,19 @@ void *strcmp_new(t_symbol *sym, long argc, t_atom *argv)
 
   // First argument:  right string buffer
   x->i_dstr2 = dstr_new();
+  x->i_sym1 = NULL;
+  x->i_sym2 = NULL;
+  x->k_dstr1 = dstr_new();
+  x->k_dstr2 = dstr_new();
+  x->k_dirty1 = 1;
+  x->k_dirty2 = 1;
   if ((argc >= 1) && (attr_args_offset((short)argc, argv) >= 1)) {
     x->i_dstr2 = str_cat_atom(x, x->i_dstr2, argv);
+    if (atom_gettype(argv) == A_SYM) { x->i_sym2 = atom_getsym(argv); }
   }
 
   // Test the string buffers
-  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2) || DSTR_IS_NULL(x->k_dstr1) || DSTR_IS_NULL(x->k_dstr2)) {
     object_error((t_object *)x, "Allocation error.");
     strcmp_free(x);
     return NULL;
@@ -171,6 +353,18 @@ void *strcmp_new(t_symbol *sym, long argc, t_atom *argv)
   // Set the remaining variables
   x->o_int1 = 0;
   x->o_int2 = -1;
+  x->o_prefix = 0;
+  x->o_suffix = 0;
+  x->d_blk_max = 0;
+  x->d_peq = NULL;
+  x->d_vp = NULL;
+  x->d_vn = NULL;
+  x->tr_cls_cnt = 0;
+  x->tr_state_cnt = 0;
+  x->tr_next = NULL;
+  x->tr_ent = NULL;
+  x->tr_dirty = 1;
+  object_attr_setlong(x, gensym("maxdist"), -1);
 
   // Process the attributes
   attr_args_process(x, (short)argc, argv);
@@ -185,6 +379,12 @@ void strcmp_free(t_strcmp *x)
 {
   dstr_free(&x->i_dstr1);
   dstr_free(&x->i_dstr2);
+  dstr_free(&x->k_dstr1);
+  dstr_free(&x->k_dstr2);
+  if (x->d_peq) { sysmem_freeptr(x->d_peq); }
+  if (x->d_vp) { sysmem_freeptr(x->d_vp); }
+  if (x->d_vn) { sysmem_freeptr(x->d_vn); }
+  strcmp_tr_free(x);
   freeobject((t_object *)x->inl_proxy);
 }
 
@@ -205,9 +405,13 @@ void strcmp_assist(t_strcmp *x, void *b, long msg, long arg, char *dst)
     switch (arg) {
     case 0: sprintf(dst, "match s1 and s2 (0 / 1)"); break;
     case 1:
-      if (x->mode == 0) { sprintf(dst, "compare s1 to s2 (-1 / 0 / 1)"); }
+      if (x->dict && (x->mode == 0)) { sprintf(dst, "index of s1 in the entries of s2 (int, -1 if none)"); }
+      else if (x->dict) { sprintf(dst, "index of s2 in the entries of s1 (int, -1 if none)"); }
+      else if (x->distance) { sprintf(dst, "edit distance (int, -1 above maxdist)"); }
+      else if (x->mode == 0) { sprintf(dst, "compare s1 to s2 (-1 / 0 / 1)"); }
       else { sprintf(dst, "compare s2 to s1 (-1 / 0 / 1)"); }
       break;
+    case 2: sprintf(dst, "common prefix length (int), and suffix length (list)"); break;
     default: break;
     }
     break;
@@ -230,8 +434,7 @@ void strcmp_int(t_strcmp *x, long n)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_int(dstr, n);
-  strcmp_action(x);
-  if (dstr == x->i_dstr1) { strcmp_output(x); }
+  strcmp_input(x, dstr, NULL, 1);
 }
 
 /****************************************************************
@@ -242,8 +445,7 @@ void strcmp_float(t_strcmp *x, double f)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_printf(dstr, x->format, f);
-  strcmp_action(x);
-  if (dstr == x->i_dstr1) { strcmp_output(x); }
+  strcmp_input(x, dstr, NULL, 1);
 }
 
 /****************************************************************
@@ -255,8 +457,7 @@ void strcmp_list(t_strcmp *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strcmp_action(x);
-  if (dstr == x->i_dstr1) { strcmp_output(x); }
+  strcmp_input(x, dstr, NULL, 1);
 }
 
 /****************************************************************
@@ -266,10 +467,13 @@ void strcmp_anything(t_strcmp *x, t_symbol *sym, long argc, t_atom *argv)
 {
   t_dstr dstr = str_proxy_to_dstr(x);
 
-  dstr_cpy_cstr(dstr, sym->s_name);
-  str_cat_args(x, dstr, argc, argv);
-  strcmp_action(x);
-  if (dstr == x->i_dstr1) { strcmp_output(x); }
+  // The string buffer already holds the same symbol
+  if (argc || (sym != ((dstr == x->i_dstr1) ? x->i_sym1 : x->i_sym2))) {
+    dstr_cpy_cstr(dstr, sym->s_name);
+    str_cat_args(x, dstr, argc, argv);
+  }
+
+  strcmp_input(x, dstr, argc ? NULL : sym, 1);
 }
 
 /****************************************************************
@@ -281,7 +485,7 @@ void strcmp_set(t_strcmp *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strcmp_action(x);
+  strcmp_input(x, dstr, ((argc == 1) && (atom_gettype(argv) == A_SYM)) ? atom_getsym(argv) : NULL, 0);
 }
 
 /****************************************************************
@@ -291,12 +495,39 @@ void strcmp_post(t_strcmp *x)
 {
   object_post((t_object *)x, "Mode:  %i", x->mode);
   object_post((t_object *)x, "Float precision:  %i", x->fprecision);
+  object_post((t_object *)x, "Ignore case:  %i - Natural: %i", x->icase, x->natural);
+  object_post((t_object *)x, "Common:  %i - Prefix: %i - Suffix: %i", x->common, x->o_prefix, x->o_suffix);
+  object_post((t_object *)x, "Distance:  %i - Max: %i - Blocks: %i", x->distance, x->maxdist, x->d_blk_max);
+  object_post((t_object *)x, "Dict:  %i - States: %i - Classes: %i", x->dict, x->tr_state_cnt, x->tr_cls_cnt);
+  object_post((t_object *)x, "Collate:  %i - Keys: %i - %i", x->collate, DSTR_LENGTH(x->k_dstr1), DSTR_LENGTH(x->k_dstr2));
   object_post((t_object *)x, "Alloc:  Left: %i - Right: %i",
     DSTR_ALLOC(x->i_dstr1), DSTR_ALLOC(x->i_dstr2));
   object_post((t_object *)x, "Left: %s", DSTR_CSTR(x->i_dstr1));
   object_post((t_object *)x, "Right: %s", DSTR_CSTR(x->i_dstr2));
 }
 
+/****************************************************************
+*  Process a new input, keeping the symbol the string was set from
+*
+*  @param dstr The string buffer that was just modified.
+*  @param sym The symbol the string was set from, or NULL.
+*  @param output Whether the input should trigger an output.
+*/
+void strcmp_input(t_strcmp *x, t_dstr dstr, t_symbol *sym, char output)
+{
+  // The string is unchanged if it was set again from the same symbol
+  if (dstr == x->i_dstr1) {
+    if (!sym || (sym != x->i_sym1)) { x->k_dirty1 = 1; if (x->mode == 1) { x->tr_dirty = 1; } }
+    x->i_sym1 = sym;
+  } else {
+    if (!sym || (sym != x->i_sym2)) { x->k_dirty2 = 1; if (x->mode == 0) { x->tr_dirty = 1; } }
+    x->i_sym2 = sym;
+  }
+
+  strcmp_action(x);
+  if (output && (dstr == x->i_dstr1)) { strcmp_output(x); }
+}
+
 /****************************************************************
 *  The specific string action
 */
@@ -312,13 +543,280 @@ void strcmp_action(t_strcmp *x)
     return;
   }
 
-  if (x->mode == 0) { cmp = memcmp(DSTR_CSTR(x->i_dstr1), DSTR_CSTR(x->i_dstr2),
-    min(DSTR_LENGTH(x->i_dstr1), DSTR_LENGTH(x->i_dstr2)) + 1); }
-  else { cmp = memcmp(DSTR_CSTR(x->i_dstr2), DSTR_CSTR(x->i_dstr1),
-    min(DSTR_LENGTH(x->i_dstr1), DSTR_LENGTH(x->i_dstr2)) + 1); }
+  if (x->common) { strcmp_common(x); }
+  if (x->dict) { strcmp_dict(x); return; }
+
+  // Same symbol:  same string
+  if (x->i_sym1 && (x->i_sym1 == x->i_sym2)) {
+    x->o_int1 = 1;
+    x->o_int2 = 0;
+    return;
+  }
+
+  t_dstr_int len1 = DSTR_LENGTH(x->i_dstr1);
+  t_dstr_int len2 = DSTR_LENGTH(x->i_dstr2);
+
+  // Compare the common length, then the lengths
+  if (x->collate) {
+    strcmp_keys(x);
+    if (DSTR_IS_NULL(x->k_dstr1) || DSTR_IS_NULL(x->k_dstr2)) {
+      x->o_int1 = 0;
+      x->o_int2 = -1;
+      object_error((t_object *)x, "collate:  Allocation error. Reset the external.");
+      return;
+    }
+
+    len1 = DSTR_LENGTH(x->k_dstr1);
+    len2 = DSTR_LENGTH(x->k_dstr2);
+    cmp = memcmp(DSTR_CSTR(x->k_dstr1), DSTR_CSTR(x->k_dstr2), min(len1, len2));
+    if (!cmp) { cmp = (len1 > len2) - (len1 < len2); }
+  } else if (x->icase || x->natural) {
+    cmp = str_compare(DSTR_CSTR(x->i_dstr1), len1, DSTR_CSTR(x->i_dstr2), len2, x->icase, x->natural);
+  } else {
+    cmp = memcmp(DSTR_CSTR(x->i_dstr1), DSTR_CSTR(x->i_dstr2), min(len1, len2));
+    if (!cmp) { cmp = (len1 > len2) - (len1 < len2); }
+  }
+  if (x->mode == 1) { cmp = -cmp; }
 
   x->o_int1 = cmp ? 0 : 1;
   x->o_int2 = (cmp < 0) ? -1 : ((cmp > 0) ? +1 : 0);
+
+  if (x->distance) { x->o_int2 = strcmp_distance(x); }
+}
+
+/****************************************************************
+*  Compute the lengths of the common prefix and suffix
+*/
+void strcmp_common(t_strcmp *x)
+{
+  t_dstr_int len1 = DSTR_LENGTH(x->i_dstr1);
+  t_dstr_int len2 = DSTR_LENGTH(x->i_dstr2);
+  t_dstr_int len = min(len1, len2);
+
+  // Same symbol:  same string
+  if (x->i_sym1 && (x->i_sym1 == x->i_sym2)) {
+    x->o_prefix = (long)len;
+    x->o_suffix = 0;
+    return;
+  }
+
+  t_dstr_int pre = str_mismatch(DSTR_CSTR(x->i_dstr1), DSTR_CSTR(x->i_dstr2), len, x->icase);
+  x->o_prefix = (long)pre;
+  x->o_suffix = (x->common == 2)
+    ? (long)str_rmismatch(DSTR_CSTR(x->i_dstr1) + len1, DSTR_CSTR(x->i_dstr2) + len2, len - pre, x->icase)
+    : 0;
+}
+
+/****************************************************************
+*  Compute the edit distance between the strings
+*
+*  The shorter string is the pattern, its bits are set in d_peq for the
+*  computation, then cleared.  The distance in the last row can decrease
+*  by at most 1 for each remaining character of the text, which gives the
+*  early exit with maxdist.
+*
+*  @return The edit distance, or -1 if it is larger than maxdist.
+*/
+long strcmp_distance(t_strcmp *x)
+{
+  const unsigned char *s1 = (const unsigned char *)DSTR_CSTR(x->i_dstr1);
+  const unsigned char *s2 = (const unsigned char *)DSTR_CSTR(x->i_dstr2);
+  t_dstr_int len1 = DSTR_LENGTH(x->i_dstr1);
+  t_dstr_int len2 = DSTR_LENGTH(x->i_dstr2);
+  const unsigned char *pat, *txt;
+  t_dstr_int m, n;
+  unsigned __int64 bit;
+  unsigned char c;
+
+  // Skip the common prefix and suffix
+  t_dstr_int pre = str_mismatch((const char *)s1, (const char *)s2, min(len1, len2), x->icase);
+  s1 += pre; len1 -= pre;
+  s2 += pre; len2 -= pre;
+  t_dstr_int suf = str_rmismatch((const char *)s1 + len1, (const char *)s2 + len2, min(len1, len2), x->icase);
+  len1 -= suf;
+  len2 -= suf;
+
+  if (len1 <= len2) { pat = s1; m = len1; txt = s2; n = len2; }
+  else { pat = s2; m = len2; txt = s1; n = len1; }
+
+  if ((x->maxdist >= 0) && ((long)(n - m) > x->maxdist)) { return -1; }
+  if (m == 0) { return (long)n; }
+
+  // Resize the buffers, cleared
+  long cnt = (long)((m + 63) / 64);
+  if (cnt > x->d_blk_max) {
+    if (x->d_peq) { sysmem_freeptr(x->d_peq); }
+    if (x->d_vp) { sysmem_freeptr(x->d_vp); }
+    if (x->d_vn) { sysmem_freeptr(x->d_vn); }
+    x->d_peq = (unsigned __int64 *)sysmem_newptrclear(sizeof(unsigned __int64) * 256 * cnt);
+    x->d_vp = (unsigned __int64 *)sysmem_newptr(sizeof(unsigned __int64) * cnt);
+    x->d_vn = (unsigned __int64 *)sysmem_newptr(sizeof(unsigned __int64) * cnt);
+    x->d_blk_max = cnt;
+
+    if (!x->d_peq || !x->d_vp || !x->d_vn) {
+      object_error((t_object *)x, "distance:  Allocation error.");
+      if (x->d_peq) { sysmem_freeptr(x->d_peq); }
+      if (x->d_vp) { sysmem_freeptr(x->d_vp); }
+      if (x->d_vn) { sysmem_freeptr(x->d_vn); }
+      x->d_peq = NULL;
+      x->d_vp = NULL;
+      x->d_vn = NULL;
+      x->d_blk_max = 0;
+      return -1;
+    }
+  }
+
+  // Set the pattern bits, on both cases of the letters with icase
+  for (t_dstr_int i = 0; i < m; i++) {
+    bit = (unsigned __int64)1 << (i % 64);
+    c = x->icase ? str_fold[pat[i]] : pat[i];
+    x->d_peq[c * cnt + i / 64] |= bit;
+    if (c != pat[i]) { x->d_peq[pat[i] * cnt + i / 64] |= bit; }
+    else if (x->icase && (c >= 'a') && (c <= 'z')) { x->d_peq[(c - 0x20) * cnt + i / 64] |= bit; }
+  }
+
+  for (long b = 0; b < cnt; b++) {
+    x->d_vp[b] = ~(unsigned __int64)0;
+    x->d_vn[b] = 0;
+  }
+
+  unsigned __int64 last = (unsigned __int64)1 << ((m - 1) % 64);
+  long dist = (long)m;
+
+  for (t_dstr_int j = 0; j < n; j++) {
+    dist += str_myers_advance(x->d_vp, x->d_vn, x->d_peq + txt[j] * cnt, cnt, last, +1);
+    if ((x->maxdist >= 0) && (dist - (long)(n - 1 - j) > x->maxdist)) { dist = -1; break; }
+  }
+
+  // Clear the pattern bits
+  for (t_dstr_int i = 0; i < m; i++) {
+    c = pat[i];
+    x->d_peq[c * cnt + i / 64] = 0;
+    x->d_peq[str_fold[c] * cnt + i / 64] = 0;
+    if ((c >= 'a') && (c <= 'z')) { x->d_peq[(c - 0x20) * cnt + i / 64] = 0; }
+  }
+
+  return dist;
+}
+
+/****************************************************************
+*  Look up the left string in the list of entries, or the right one with mode 1
+*/
+void strcmp_dict(t_strcmp *x)
+{
+  t_dstr key = (x->mode == 1) ? x->i_dstr2 : x->i_dstr1;
+  const unsigned char *s = (const unsigned char *)DSTR_CSTR(key);
+  t_dstr_int len = DSTR_LENGTH(key);
+  long ent = 0;
+  long st = 0;
+
+  if (x->tr_dirty) { strcmp_tr_build(x); x->tr_dirty = 0; }
+
+  x->o_int1 = 0;
+  x->o_int2 = -1;
+  if (!x->tr_next) { return; }
+
+  long k = x->tr_cls_cnt;
+  for (t_dstr_int i = 0; i < len; i++) {
+    st = x->tr_next[st * k + x->tr_cls[s[i]]];
+    if (!st) { break; }
+    if (x->dict == 2) { if (x->tr_ent[st]) { ent = x->tr_ent[st]; } }
+    else if (i == len - 1) { ent = x->tr_ent[st]; }
+  }
+
+  x->o_int1 = ent ? 1 : 0;
+  x->o_int2 = ent - 1;
+}
+
+/****************************************************************
+*  Compile the list of entries into a trie
+*
+*  Each state has a row of transitions, one per class of the bytes used in
+*  the entries, with class 0 for all the other bytes, so that the lookup does
+*  a single load per byte.  The table is allocated for the worst case of one
+*  state per byte, then shrunk to the states actually created.
+*/
+void strcmp_tr_build(t_strcmp *x)
+{
+  t_dstr list = (x->mode == 1) ? x->i_dstr1 : x->i_dstr2;
+  const unsigned char *ent = (const unsigned char *)DSTR_CSTR(list);
+  t_dstr_int len = DSTR_LENGTH(list);
+
+  strcmp_tr_free(x);
+
+  // Character classes:  upper case letters share the class of their lower case
+  memset(x->tr_cls, 0, sizeof(x->tr_cls));
+  x->tr_cls_cnt = 1;
+  for (t_dstr_int i = 0; i < len; i++) {
+    unsigned char c = x->icase ? str_fold[ent[i]] : ent[i];
+    if ((c != ' ') && !x->tr_cls[c]) { x->tr_cls[c] = x->tr_cls_cnt++; }
+  }
+  if (x->icase) {
+    for (int c = 0; c < 256; c++) { x->tr_cls[c] = x->tr_cls[str_fold[c]]; }
+  }
+
+  // Allocate for the maximum number of states:  the root and one per character
+  long max = 1 + (long)len;
+  long k = x->tr_cls_cnt;
+  x->tr_next = (long *)sysmem_newptrclear(sizeof(long) * max * k);
+  x->tr_ent = (long *)sysmem_newptrclear(sizeof(long) * max);
+
+  if (!x->tr_next || !x->tr_ent) {
+    object_error((t_object *)x, "dict:  Allocation error.");
+    strcmp_tr_free(x);
+    return;
+  }
+
+  // Build the trie, with 0 as the root and as "no transition"
+  long cnt = 1;
+  long ind = 0;
+  long st;
+  t_dstr_int i = 0;
+
+  while (i < len) {
+    while ((i < len) && (ent[i] == ' ')) { i++; }
+    if (i == len) { break; }
+
+    ind++;
+    st = 0;
+    for (; (i < len) && (ent[i] != ' '); i++) {
+      long *next = x->tr_next + st * k + x->tr_cls[ent[i]];
+      if (!*next) { *next = cnt++; }
+      st = *next;
+    }
+    if (!x->tr_ent[st]) { x->tr_ent[st] = ind; }
+  }
+  x->tr_state_cnt = cnt;
+
+  // Shrink to the states used:  shared prefixes leave the rest empty
+  if (cnt < max) {
+    long *next = (long *)sysmem_resizeptr(x->tr_next, sizeof(long) * cnt * k);
+    long *ents = (long *)sysmem_resizeptr(x->tr_ent, sizeof(long) * cnt);
+    if (next) { x->tr_next = next; }
+    if (ents) { x->tr_ent = ents; }
+  }
+}
+
+/****************************************************************
+*  Free the trie
+*/
+void strcmp_tr_free(t_strcmp *x)
+{
+  if (x->tr_next) { sysmem_freeptr(x->tr_next); }
+  if (x->tr_ent) { sysmem_freeptr(x->tr_ent); }
+
+  x->tr_next = NULL;
+  x->tr_ent = NULL;
+  x->tr_state_cnt = 0;
+}
+
+/****************************************************************
+*  Update the sort keys of the strings that changed
+*/
+void strcmp_keys(t_strcmp *x)
+{
+  if (x->k_dirty1) { str_xfrm(x->k_dstr1, x->i_dstr1); x->k_dirty1 = 0; }
+  if (x->k_dirty2) { str_xfrm(x->k_dstr2, x->i_dstr2); x->k_dirty2 = 0; }
 }
 
 /****************************************************************
@@ -326,10 +824,297 @@ void strcmp_action(t_strcmp *x)
 */
 void strcmp_output(t_strcmp *x)
 {
+  t_atom atoms[2];
+
+  switch (x->common) {
+  case 1: outlet_int(x->outl_any, x->o_prefix); break;
+  case 2:
+    atom_setlong(atoms, x->o_prefix);
+    atom_setlong(atoms + 1, x->o_suffix);
+    outlet_list(x->outl_any, NULL, 2, atoms);
+    break;
+  default: break;
+  }
+
   outlet_int(x->outl_int2, x->o_int2);
   outlet_int(x->outl_int1, x->o_int1);
 }
 
+/****************************************************************
+*  Compare two strings, ignoring case or in natural order
+*
+*  The common prefix is skipped with str_mismatch().  In natural order,
+*  the comparison resumes at the start of the digit run containing the
+*  first difference.
+*
+*  @return -1, 0 or 1, as the first string is before, equal or after the second.
+*/
+int str_compare(const char *str1, t_dstr_int len1, const char *str2, t_dstr_int len2, long icase, long natural)
+{
+  const unsigned char *s1 = (const unsigned char *)str1;
+  const unsigned char *s2 = (const unsigned char *)str2;
+  t_dstr_int len = min(len1, len2);
+  t_dstr_int i = str_mismatch(str1, str2, len, icase);
+  unsigned char c1;
+  unsigned char c2;
+
+  if (natural) {
+    while ((i > 0) && STR_IS_DIGIT(s1[i - 1])) { i--; }
+    return str_natural(s1, len1, s2, len2, i, icase);
+  }
+
+  while (i < len) {
+    c1 = str_fold_at(s1, i, icase);
+    c2 = str_fold_at(s2, i, icase);
+    if (c1 != c2) { return (c1 < c2) ? -1 : 1; }
+
+    // Latin-1 letters that only differ by case
+    i++;
+    i += str_mismatch(str1 + i, str2 + i, len - i, icase);
+  }
+
+  return (len1 > len2) - (len1 < len2);
+}
+
+/****************************************************************
+*  Compare two strings in natural order, from a position in both
+*
+*  @return -1, 0 or 1, as the first string is before, equal or after the second.
+*/
+int str_natural(const unsigned char *s1, t_dstr_int len1, const unsigned char *s2, t_dstr_int len2, t_dstr_int i, long icase)
+{
+  t_dstr_int i1 = i;
+  t_dstr_int i2 = i;
+  t_dstr_int z1, z2, e1, e2;
+  unsigned char c1;
+  unsigned char c2;
+  int zeros = 0;
+  int cmp;
+
+  while ((i1 < len1) && (i2 < len2)) {
+    if (STR_IS_DIGIT(s1[i1]) && STR_IS_DIGIT(s2[i2])) {
+      // Skip the leading zeros, then compare the number of digits, then the digits
+      for (z1 = i1; (z1 < len1) && (s1[z1] == '0'); z1++) {}
+      for (z2 = i2; (z2 < len2) && (s2[z2] == '0'); z2++) {}
+      for (e1 = z1; (e1 < len1) && STR_IS_DIGIT(s1[e1]); e1++) {}
+      for (e2 = z2; (e2 < len2) && STR_IS_DIGIT(s2[e2]); e2++) {}
+
+      if (e1 - z1 != e2 - z2) { return (e1 - z1 < e2 - z2) ? -1 : 1; }
+      cmp = memcmp(s1 + z1, s2 + z2, e1 - z1);
+      if (cmp) { return (cmp < 0) ? -1 : 1; }
+      if (!zeros && (z1 - i1 != z2 - i2)) { zeros = (z1 - i1 < z2 - i2) ? -1 : 1; }
+
+      i1 = e1;
+      i2 = e2;
+      continue;
+    }
+
+    c1 = str_fold_at(s1, i1, icase);
+    c2 = str_fold_at(s2, i2, icase);
+    if (c1 != c2) { return (c1 < c2) ? -1 : 1; }
+    i1++;
+    i2++;
+  }
+
+  if ((i1 < len1) || (i2 < len2)) { return (i1 < len1) ? 1 : -1; }
+  return zeros;
+}
+
+/****************************************************************
+*  Find the first difference between two strings of the same length
+*
+*  With SSE2, 32 characters are compared at a time, and the first zero bit
+*  of the joined equality masks is the first difference.  With icase,
+*  the ASCII letters are folded, in the registers with SSE2.
+*
+*  @return The 0-based position of the first difference, or the length.
+*/
+t_dstr_int str_mismatch(const char *str1, const char *str2, t_dstr_int len, long icase)
+{
+  const unsigned char *s1 = (const unsigned char *)str1;
+  const unsigned char *s2 = (const unsigned char *)str2;
+  t_dstr_int i = 0;
+
+#ifdef STR_SSE2
+  __m128i v1, v2, w1, w2;
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; i + 32 <= len; i += 32) {
+    v1 = _mm_loadu_si128((const __m128i *)(str1 + i));
+    v2 = _mm_loadu_si128((const __m128i *)(str2 + i));
+    w1 = _mm_loadu_si128((const __m128i *)(str1 + i + 16));
+    w2 = _mm_loadu_si128((const __m128i *)(str2 + i + 16));
+    if (icase) {
+      v1 = str_fold_sse2(v1);
+      v2 = str_fold_sse2(v2);
+      w1 = str_fold_sse2(w1);
+      w2 = str_fold_sse2(w2);
+    }
+
+    mask = ~((unsigned long)_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2))
+      | ((unsigned long)_mm_movemask_epi8(_mm_cmpeq_epi8(w1, w2)) << 16)) & 0xFFFFFFFF;
+    if (mask) {
+      _BitScanForward(&bit, mask);
+      return i + bit;
+    }
+  }
+#endif
+
+  if (icase) {
+    for (; i < len; i++) { if (str_fold[s1[i]] != str_fold[s2[i]]) { return i; } }
+  } else {
+    for (; i < len; i++) { if (s1[i] != s2[i]) { return i; } }
+  }
+
+  return len;
+}
+
+/****************************************************************
+*  Find the length of the common suffix of two strings, from their ends
+*
+*  As str_mismatch() backwards:  the last zero bit of the joined equality
+*  masks is the last difference.
+*
+*  @param len The maximum length of the suffix.
+*
+*  @return The length of the common suffix.
+*/
+t_dstr_int str_rmismatch(const char *end1, const char *end2, t_dstr_int len, long icase)
+{
+  const unsigned char *e1 = (const unsigned char *)end1;
+  const unsigned char *e2 = (const unsigned char *)end2;
+  t_dstr_int n = 0;
+
+#ifdef STR_SSE2
+  __m128i v1, v2, w1, w2;
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; n + 32 <= len; n += 32) {
+    v1 = _mm_loadu_si128((const __m128i *)(end1 - n - 32));
+    v2 = _mm_loadu_si128((const __m128i *)(end2 - n - 32));
+    w1 = _mm_loadu_si128((const __m128i *)(end1 - n - 16));
+    w2 = _mm_loadu_si128((const __m128i *)(end2 - n - 16));
+    if (icase) {
+      v1 = str_fold_sse2(v1);
+      v2 = str_fold_sse2(v2);
+      w1 = str_fold_sse2(w1);
+      w2 = str_fold_sse2(w2);
+    }
+
+    mask = ~((unsigned long)_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2))
+      | ((unsigned long)_mm_movemask_epi8(_mm_cmpeq_epi8(w1, w2)) << 16)) & 0xFFFFFFFF;
+    if (mask) {
+      _BitScanReverse(&bit, mask);
+      return n + 31 - bit;
+    }
+  }
+#endif
+
+  if (icase) {
+    for (; n < len; n++) { if (str_fold[e1[-1 - (long)n]] != str_fold[e2[-1 - (long)n]]) { break; } }
+  } else {
+    for (; n < len; n++) { if (e1[-1 - (long)n] != e2[-1 - (long)n]) { break; } }
+  }
+
+  return n;
+}
+
+/****************************************************************
+*  Advance the bit-parallel edit distance computation by one column
+*
+*  @param eq The match bitmasks of the text character, for each block.
+*  @param last The bit of the last pattern character in the last block.
+*  @param hin The horizontal delta entering the first block:  +1 for the
+*  distance between whole strings.
+*
+*  @return The horizontal delta leaving the last row.
+*/
+long str_myers_advance(unsigned __int64 *vp, unsigned __int64 *vn, const unsigned __int64 *eq, long blk_cnt, unsigned __int64 last, long hin)
+{
+  unsigned __int64 high = (unsigned __int64)1 << 63;
+  unsigned __int64 pv, mv, e, xv, xh, ph, mh;
+  long hout;
+
+  for (long b = 0; b < blk_cnt; b++) {
+    if (b == blk_cnt - 1) { high = last; }
+    pv = vp[b];
+    mv = vn[b];
+    e = eq[b];
+
+    xv = e | mv;
+    if (hin < 0) { e |= 1; }
+    xh = (((e & pv) + pv) ^ pv) | e;
+    ph = mv | ~(xh | pv);
+    mh = pv & xh;
+
+    hout = (ph & high) ? 1 : ((mh & high) ? -1 : 0);
+
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0) { mh |= 1; }
+    else if (hin > 0) { ph |= 1; }
+
+    vp[b] = mh | ~(xv | ph);
+    vn[b] = ph & xv;
+    hin = hout;
+  }
+
+  return hin;
+}
+
+/****************************************************************
+*  Get a character folded to lower case
+*
+*  With icase 2, a UTF-8 continuation byte following 0xC3 is folded
+*  from the Latin-1 upper case letters, except the multiplication sign.
+*/
+unsigned char str_fold_at(const unsigned char *str, t_dstr_int i, long icase)
+{
+  unsigned char c = str[i];
+
+  if (!icase) { return c; }
+  if ((icase == 2) && (i > 0) && (str[i - 1] == 0xC3) && (c >= 0x80) && (c <= 0x9E) && (c != 0x97)) { return c + 0x20; }
+  return str_fold[c];
+}
+
+#ifdef STR_SSE2
+/****************************************************************
+*  Fold 16 characters to lower case:  ASCII letters only
+*/
+__m128i str_fold_sse2(__m128i v)
+{
+  __m128i is_upper = _mm_and_si128(
+    _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+
+  return _mm_or_si128(v, _mm_and_si128(is_upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+/****************************************************************
+*  Compute the sort key of a string in the collation locale
+*
+*  Without a locale, or if the string cannot be transformed, the key is
+*  the string itself.
+*
+*  @return The key, NULL if there is an allocation error.
+*/
+t_dstr str_xfrm(t_dstr key, t_dstr src)
+{
+  size_t len;
+
+  if (!str_locale || ((len = _strxfrm_l(NULL, DSTR_CSTR(src), 0, str_locale)) >= INT_MAX)) {
+    return dstr_cpy_dstr(key, src);
+  }
+
+  if (len > DSTR_ALLOC(key)) { dstr_resize(key, (t_dstr_int)len); }
+  if (DSTR_IS_NULL(key)) { return key; }
+
+  _strxfrm_l(DSTR_CSTR(key), DSTR_CSTR(src), len + 1, str_locale);
+  return dstr_update(key);
+}
+
 /****************************************************************
 *  Get the destination buffer depending on the proxy
 */
@@ -375,6 +1160,7 @@ t_dstr str_cat_args(t_strcmp *x, t_dstr dstr, long argc, t_atom *argv)
 t_max_err str_mode_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
 {
   if (argc && argv) { x->mode = (long)atom_getlong(argv); } else { x->mode = 0; }
+  x->tr_dirty = 1;
 
   strcmp_action(x);
   return MAX_ERR_NONE;
@@ -393,3 +1179,81 @@ t_max_err str_fprecision_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
 
   return MAX_ERR_NONE;
 }
+
+/****************************************************************
+*  Custom setter for the ignore case attribute
+*/
+t_max_err str_icase_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->icase = (long)atom_getlong(argv); } else { x->icase = 0; }
+  x->tr_dirty = 1;
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the natural attribute
+*/
+t_max_err str_natural_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->natural = (long)atom_getlong(argv); } else { x->natural = 0; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the common attribute
+*/
+t_max_err str_common_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->common = (long)atom_getlong(argv); } else { x->common = 0; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the distance attribute
+*/
+t_max_err str_distance_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->distance = (long)atom_getlong(argv); } else { x->distance = 0; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the maximum distance attribute
+*/
+t_max_err str_maxdist_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->maxdist = (long)atom_getlong(argv); } else { x->maxdist = -1; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the dictionary attribute
+*/
+t_max_err str_dict_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->dict = (long)atom_getlong(argv); } else { x->dict = 0; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the collation attribute
+*/
+t_max_err str_collate_set(t_strcmp *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->collate = (long)atom_getlong(argv); } else { x->collate = 0; }
+
+  strcmp_action(x);
+  return MAX_ERR_NONE;
+}
@@ -8,6 +8,39 @@
 *    - the new style Max object,
 *    - dynamic strings,
 *    - attributes.
+*
+*  Fields (fields 1):  the right inlet also takes a list of cutting positions,
+*  and all the pieces are sent as one message from the left outlet.  With
+*  fields 2, the list holds (start, length) pairs, one for each field.  The
+*  fields are interned straight from the input string, without copies.
+*
+*  Substring (substr 1):  the right inlet takes a start, or a (start, length)
+*  pair, and only the substring is sent from the left outlet.
+*
+*  Negative values (negative 1):  positions and starts count from the end,
+*  as in Python:  -1 is before the last character.  A negative length stops
+*  that many characters before the end.  With negative 0, the default,
+*  negative positions and starts are clipped to 0, and negative lengths
+*  give empty pieces, as in the earlier versions.
+*
+*  Fields take precedence over substr, and substr over delim:  the right
+*  inlet only takes a delimiter when the cut is at the delimiter.
+*
+*  The outputs attribute enables the left (1) and right (2) outlets:  the
+*  pieces for a disabled outlet are not computed.
+*
+*  Delimiter (delim 1):  the string is cut around the first occurrence of the
+*  delimiter set with a symbol in the right inlet, or the last with delim 2,
+*  and the delimiter is left out.  If it is not found, the whole string is
+*  sent as the left part (delim 1) or as the right part (delim 2).  The
+*  delimiter is searched with SSE2, filtering on its first and last bytes.
+*
+*  UTF-8 (utf8 1):  positions and lengths count codepoints instead of bytes,
+*  so that multi-byte sequences are never split.  A codepoint starts at each
+*  byte that is not a continuation byte, and the codepoints are counted 16
+*  bytes at a time with SSE2.  With utf8 2, the byte offset of every 256th
+*  codepoint is kept in a sparse index, built once for each input string, so
+*  that repeated cuts start scanning from the nearest indexed codepoint.
 */
 
 /****************************************************************
@@ -17,9 +50,20 @@
 #include "ext_obex.h"
 #include "dstring.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STR_SSE2 1
+#include <intrin.h>
+#endif
+
 /****************************************************************
 *  Preprocessor
 */
+#define STR_POS_ALLOC 16
+#define STR_POS_MAX   32767   // outlet_anything() takes a short count
+#define STR_UTF8_STEP 256     // codepoints between offsets of the sparse index
+
+// The right inlet takes the delimiter only when the cut is at the delimiter
+#define STR_DELIM_INPUT(x) ((x)->delim && !(x)->fields && !(x)->substr)
 
 /****************************************************************
 *  Max object structure
@@ -28,18 +72,37 @@ typedef struct _strcut
 {
   t_object obj;
 
+  void *inl_proxy;
+  long  inl_proxy_ind;
   void *outl_any1;
   void *outl_any2;
 
   t_dstr i_dstr;
   long   i_pos;
+  long  *i_cut_arr;     // cutting positions, or (start, length) pairs
+  long   i_cut_cnt;
+  long   i_cut_max;
+  t_dstr i_delim;
+
+  t_dstr_int *u_ix;     // byte offsets of every STR_UTF8_STEP codepoints
+  long        u_ix_cnt;
+  long        u_ix_max;
+  t_dstr_int  u_cnt;    // number of codepoints
+  char        u_dirty;
 
-  t_dstr    o_dstr1;
-  t_dstr    o_dstr2;
   t_symbol *o_sym1;
   t_symbol *o_sym2;
+  t_atom   *o_arr;
+  short     o_max;
+  short     o_cnt;
 
   long  mode;
+  long  fields;
+  long  substr;
+  long  outputs;
+  long  delim;
+  long  utf8;
+  long  negative;
   long  fprecision;
   char  format[6];
 
@@ -59,7 +122,6 @@ void  strcut_assist   (t_strcut *x, void *b, long msg, long arg, char *dst);
 
 void  strcut_bang     (t_strcut *x);
 void  strcut_int      (t_strcut *x, t_atom_long n);
-void  strcut_in1      (t_strcut *x, t_atom_long n);
 void  strcut_float    (t_strcut *x, double f);
 void  strcut_list     (t_strcut *x, t_symbol *sym, long argc, t_atom *argv);
 void  strcut_anything (t_strcut *x, t_symbol *sym, long argc, t_atom *argv);
@@ -67,11 +129,31 @@ void  strcut_set      (t_strcut *x, t_symbol *sym, long argc, t_atom *argv);
 void  strcut_post     (t_strcut *x);
 
 void  strcut_action   (t_strcut *x);
+void  strcut_fields   (t_strcut *x);
+void  strcut_add      (t_strcut *x, t_symbol *sym);
+long  strcut_resolve  (t_strcut *x, long pos);
+void  strcut_range    (t_strcut *x, long start, long length, long *beg, long *end);
+void  strcut_utf8_index (t_strcut *x);
 void  strcut_output   (t_strcut *x);
 
+t_symbol *str_gensym_span    (char *str, t_dstr_int len);
+long      str_index          (long pos, long len, long neg);
+void      str_range          (long start, long length, long len, long neg, long *beg, long *end);
+t_dstr_int str_memmem        (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n);
+t_dstr_int str_rmemmem       (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n);
+t_dstr_int str_utf8_count    (const char *str, t_dstr_int len);
+t_dstr_int str_utf8_skip     (const char *str, t_dstr_int len, t_dstr_int i, t_dstr_int cnt);
+
 t_dstr    str_cat_atom       (t_strcut *x, t_dstr dstr, t_atom *atom);
 t_dstr    str_cat_args       (t_strcut *x, t_dstr dstr, long argc, t_atom *argv);
 t_max_err str_fprecision_set (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_mode_set       (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_fields_set     (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_substr_set     (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_outputs_set    (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_delim_set      (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_utf8_set       (t_strcut *x, void *attr, long argc, t_atom *argv);
+t_max_err str_negative_set   (t_strcut *x, void *attr, long argc, t_atom *argv);
 
 /****************************************************************
 *  Initialization
@@ -90,7 +172,6 @@ void ext_main(void *r)
   class_addmethod(c, (method)strcut_assist,   "assist",    A_CANT,  0);
   class_addmethod(c, (method)strcut_bang,     "bang",               0);
   class_addmethod(c, (method)strcut_int,      "int",       A_LONG,  0);
-  class_addmethod(c, (method)strcut_in1,      "in1",       A_LONG,  0);
   class_addmethod(c, (method)strcut_float,    "float",     A_FLOAT, 0);
   class_addmethod(c, (method)strcut_list,     "list",      A_GIMME, 0);
   class_addmethod(c, (method)strcut_anything, "anything",  A_GIMME, 0);
@@ -104,6 +185,7 @@ void ext_main(void *r)
   CLASS_ATTR_FILTER_CLIP(c, "mode", 0, 1);        // min-max filter
   CLASS_ATTR_SAVE(c, "mode", 0);                  // save with patcher
   CLASS_ATTR_SELFSAVE(c, "mode", 0);              // display as saved
+  CLASS_ATTR_ACCESSORS(c, "mode", NULL, str_mode_set);
 
   CLASS_ATTR_LONG(c, "fprecision", 0, t_strcut, fprecision);
   CLASS_ATTR_ORDER(c, "fprecision", 0, "2");
@@ -113,6 +195,54 @@ void ext_main(void *r)
   CLASS_ATTR_SELFSAVE(c, "fprecision", 0);
   CLASS_ATTR_ACCESSORS(c, "fprecision", NULL, str_fprecision_set);
 
+  CLASS_ATTR_LONG(c, "fields", 0, t_strcut, fields);
+  CLASS_ATTR_ORDER(c, "fields", 0, "3");
+  CLASS_ATTR_LABEL(c, "fields", 0, "fields");
+  CLASS_ATTR_FILTER_CLIP(c, "fields", 0, 2);
+  CLASS_ATTR_SAVE(c, "fields", 0);
+  CLASS_ATTR_SELFSAVE(c, "fields", 0);
+  CLASS_ATTR_ACCESSORS(c, "fields", NULL, str_fields_set);
+
+  CLASS_ATTR_LONG(c, "substr", 0, t_strcut, substr);
+  CLASS_ATTR_ORDER(c, "substr", 0, "4");
+  CLASS_ATTR_LABEL(c, "substr", 0, "substring");
+  CLASS_ATTR_FILTER_CLIP(c, "substr", 0, 1);
+  CLASS_ATTR_SAVE(c, "substr", 0);
+  CLASS_ATTR_SELFSAVE(c, "substr", 0);
+  CLASS_ATTR_ACCESSORS(c, "substr", NULL, str_substr_set);
+
+  CLASS_ATTR_LONG(c, "outputs", 0, t_strcut, outputs);
+  CLASS_ATTR_ORDER(c, "outputs", 0, "5");
+  CLASS_ATTR_LABEL(c, "outputs", 0, "enabled outlets");
+  CLASS_ATTR_FILTER_CLIP(c, "outputs", 0, 3);
+  CLASS_ATTR_SAVE(c, "outputs", 0);
+  CLASS_ATTR_SELFSAVE(c, "outputs", 0);
+  CLASS_ATTR_ACCESSORS(c, "outputs", NULL, str_outputs_set);
+
+  CLASS_ATTR_LONG(c, "delim", 0, t_strcut, delim);
+  CLASS_ATTR_ORDER(c, "delim", 0, "6");
+  CLASS_ATTR_LABEL(c, "delim", 0, "cut at delimiter");
+  CLASS_ATTR_FILTER_CLIP(c, "delim", 0, 2);
+  CLASS_ATTR_SAVE(c, "delim", 0);
+  CLASS_ATTR_SELFSAVE(c, "delim", 0);
+  CLASS_ATTR_ACCESSORS(c, "delim", NULL, str_delim_set);
+
+  CLASS_ATTR_LONG(c, "utf8", 0, t_strcut, utf8);
+  CLASS_ATTR_ORDER(c, "utf8", 0, "7");
+  CLASS_ATTR_LABEL(c, "utf8", 0, "UTF-8 codepoints");
+  CLASS_ATTR_FILTER_CLIP(c, "utf8", 0, 2);
+  CLASS_ATTR_SAVE(c, "utf8", 0);
+  CLASS_ATTR_SELFSAVE(c, "utf8", 0);
+  CLASS_ATTR_ACCESSORS(c, "utf8", NULL, str_utf8_set);
+
+  CLASS_ATTR_LONG(c, "negative", 0, t_strcut, negative);
+  CLASS_ATTR_ORDER(c, "negative", 0, "8");
+  CLASS_ATTR_LABEL(c, "negative", 0, "negative from the end");
+  CLASS_ATTR_FILTER_CLIP(c, "negative", 0, 1);
+  CLASS_ATTR_SAVE(c, "negative", 0);
+  CLASS_ATTR_SELFSAVE(c, "negative", 0);
+  CLASS_ATTR_ACCESSORS(c, "negative", NULL, str_negative_set);
+
   class_register(CLASS_BOX, c);
   strcut_class = c;
 }
@@ -131,18 +261,34 @@ void *strcut_new(t_symbol *sym, long argc, t_atom *argv)
     return NULL;
   }
 
-  // Set inlets and outlets
-  intin(x, 1);
+  // Set inlets, outlets, and proxy
+  x->inl_proxy_ind = 0;
+  x->inl_proxy = proxy_new((t_object *)x, 1, &x->inl_proxy_ind);
   x->outl_any2 = outlet_new((t_object *)x, NULL);
   x->outl_any1 = outlet_new((t_object *)x, NULL);
 
   // Set the string buffers
-  x->i_dstr    = dstr_new();
-  x->o_dstr1  = dstr_new();
-  x->o_dstr2 = dstr_new();
+  x->i_dstr = dstr_new();
+  x->i_delim = dstr_new();
   x->o_sym1 = gensym("");
   x->o_sym2 = gensym("");
-  if (DSTR_IS_NULL(x->i_dstr) || DSTR_IS_NULL(x->o_dstr1) || DSTR_IS_NULL(x->o_dstr2)) {
+
+  // Set the arrays of cutting positions and fields
+  x->i_cut_cnt = 0;
+  x->i_cut_max = STR_POS_ALLOC;
+  x->i_cut_arr = (long *)sysmem_newptr(sizeof(long) * x->i_cut_max);
+  x->o_cnt = 0;
+  x->o_max = STR_POS_ALLOC;
+  x->o_arr = (t_atom *)sysmem_newptr(sizeof(t_atom) * x->o_max);
+
+  // The sparse index is allocated when first built
+  x->u_ix = NULL;
+  x->u_ix_cnt = 0;
+  x->u_ix_max = 0;
+  x->u_cnt = 0;
+  x->u_dirty = 1;
+
+  if (DSTR_IS_NULL(x->i_dstr) || DSTR_IS_NULL(x->i_delim) || !x->i_cut_arr || !x->o_arr) {
     object_error((t_object *)x, "Allocation error.");
     strcut_free(x);
     return NULL;
@@ -151,10 +297,10 @@ void *strcut_new(t_symbol *sym, long argc, t_atom *argv)
   // First argument:  cutting index
   x->i_pos = 0;
   if ((argc >= 1) && (attr_args_offset((short)argc, argv) >= 1)) {
-    if ((atom_gettype(argv) == A_LONG) && (atom_getlong(argv) >= 0)) {
+    if (atom_gettype(argv) == A_LONG) {
       x->i_pos = (long)atom_getlong(argv);
     } else {
-      object_error((t_object *)x, "Arg 1:  Cutting index:  Positive int expected");
+      object_error((t_object *)x, "Arg 1:  Cutting index:  Int expected");
     }
   }
 
@@ -167,6 +313,7 @@ void *strcut_new(t_symbol *sym, long argc, t_atom *argv)
       object_error((t_object *)x, "Arg 2:  Mode:  0 or 1 expected");
     }
   }
+  object_attr_setlong(x, gensym("outputs"), 3);
   object_attr_setlong(x, gensym("mode"), mode);
 
   // Set the float precision
@@ -184,8 +331,11 @@ void *strcut_new(t_symbol *sym, long argc, t_atom *argv)
 void strcut_free(t_strcut *x)
 {
   dstr_free(&x->i_dstr);
-  dstr_free(&x->o_dstr1);
-  dstr_free(&x->o_dstr2);
+  dstr_free(&x->i_delim);
+  if (x->i_cut_arr) { sysmem_freeptr(x->i_cut_arr); }
+  if (x->o_arr) { sysmem_freeptr(x->o_arr); }
+  if (x->u_ix) { sysmem_freeptr(x->u_ix); }
+  freeobject((t_object *)x->inl_proxy);
 }
 
 /****************************************************************
@@ -197,12 +347,20 @@ void strcut_assist(t_strcut *x, void *b, long msg, long arg, char *dst)
   case ASSIST_INLET:
     switch (arg) {
     case 0: sprintf(dst, "string to cut (int, float, symbol, list)"); break;
-    case 1: sprintf(dst, "cutting position (int)"); break;
+    case 1:
+      if (x->fields == 2) { sprintf(dst, "(start, length) pairs (list)"); }
+      else if (x->fields) { sprintf(dst, "cutting positions (list)"); }
+      else if (x->substr) { sprintf(dst, "start (int) or start and length (list)"); }
+      else if (x->delim) { sprintf(dst, "delimiter (int, float, symbol, list)"); }
+      else { sprintf(dst, "cutting position (int) or positions (list)"); }
+      break;
     default: break;
     }
     break;
   case ASSIST_OUTLET:
-    if (x->mode == arg) { sprintf(dst, "left portion of cut string (symbol)"); }
+    if (x->fields && (arg == 0)) { sprintf(dst, "fields of the string (list)"); }
+    else if (x->substr && (arg == 0)) { sprintf(dst, "substring (symbol)"); }
+    else if (x->mode == arg) { sprintf(dst, "left portion of cut string (symbol)"); }
     else { sprintf(dst, "right portion of cut string (symbol)"); }
     break;
   }
@@ -221,26 +379,34 @@ void strcut_bang(t_strcut *x)
 */
 void strcut_int(t_strcut *x, t_atom_long n)
 {
+  // Right inlet:  cutting position, or delimiter
+  if (proxy_getinlet((t_object *)x) == 1) {
+    if (STR_DELIM_INPUT(x)) { dstr_cpy_int(x->i_delim, n); strcut_action(x); return; }
+    x->i_pos = (long)n;
+    x->i_cut_cnt = 0;
+    strcut_action(x);
+    return;
+  }
+
   dstr_cpy_int(x->i_dstr, n);
+  x->u_dirty = 1;
   strcut_action(x);
   strcut_output(x);
 }
 
-/****************************************************************
-*  Process int inputs
-*/
-void strcut_in1(t_strcut *x, t_atom_long n)
-{
-  x->i_pos = (long)((n >= 0) ? n : 0);
-  strcut_action(x);
-}
-
 /****************************************************************
 *  Process float inputs
 */
 void strcut_float(t_strcut *x, double f)
 {
+  if (proxy_getinlet((t_object *)x) == 1) {
+    if (STR_DELIM_INPUT(x)) { dstr_cpy_printf(x->i_delim, x->format, f); strcut_action(x); }
+    else { strcut_int(x, (t_atom_long)f); }
+    return;
+  }
+
   dstr_cpy_printf(x->i_dstr, x->format, f);
+  x->u_dirty = 1;
   strcut_action(x);
   strcut_output(x);
 }
@@ -250,8 +416,32 @@ void strcut_float(t_strcut *x, double f)
 */
 void strcut_list(t_strcut *x, t_symbol *sym, long argc, t_atom *argv)
 {
+  // Right inlet:  list of cutting positions, or delimiter
+  if (proxy_getinlet((t_object *)x) == 1) {
+    if (STR_DELIM_INPUT(x)) {
+      dstr_empty(x->i_delim);
+      str_cat_args(x, x->i_delim, argc, argv);
+      strcut_action(x);
+      return;
+    }
+
+    if (argc > x->i_cut_max) {
+      long *arr = (long *)sysmem_resizeptr(x->i_cut_arr, sizeof(long) * argc);
+      if (!arr) { object_error((t_object *)x, "fields:  Allocation error."); return; }
+      x->i_cut_arr = arr;
+      x->i_cut_max = argc;
+    }
+
+    for (long i = 0; i < argc; i++) { x->i_cut_arr[i] = (long)atom_getlong(argv + i); }
+    x->i_cut_cnt = argc;
+    x->i_pos = argc ? x->i_cut_arr[0] : 0;
+    strcut_action(x);
+    return;
+  }
+
   dstr_empty(x->i_dstr);
   str_cat_args(x, x->i_dstr, argc, argv);
+  x->u_dirty = 1;
   strcut_action(x);
   strcut_output(x);
 }
@@ -261,8 +451,18 @@ void strcut_list(t_strcut *x, t_symbol *sym, long argc, t_atom *argv)
 */
 void strcut_anything(t_strcut *x, t_symbol *sym, long argc, t_atom *argv)
 {
+  // Right inlet:  delimiter only
+  if (proxy_getinlet((t_object *)x) == 1) {
+    if (!STR_DELIM_INPUT(x)) { object_error((t_object *)x, "Right inlet:  int or list expected"); return; }
+    dstr_cpy_cstr(x->i_delim, sym->s_name);
+    str_cat_args(x, x->i_delim, argc, argv);
+    strcut_action(x);
+    return;
+  }
+
   dstr_cpy_cstr(x->i_dstr, sym->s_name);
   str_cat_args(x, x->i_dstr, argc, argv);
+  x->u_dirty = 1;
   strcut_action(x);
   strcut_output(x);
 }
@@ -274,6 +474,7 @@ void strcut_set(t_strcut *x, t_symbol *sym, long argc, t_atom *argv)
 {
   dstr_empty(x->i_dstr);
   str_cat_args(x, x->i_dstr, argc, argv);
+  x->u_dirty = 1;
   strcut_action(x);
 }
 
@@ -284,61 +485,439 @@ void strcut_post(t_strcut *x)
 {
   object_post((t_object *)x, "Mode:  %i", x->mode);
   object_post((t_object *)x, "Float precision:  %i", x->fprecision);
-  object_post((t_object *)x, "Alloc:  In: %i - Left: %i - Right: %i",
-    DSTR_ALLOC(x->i_dstr), DSTR_ALLOC(x->o_dstr1), DSTR_ALLOC(x->o_dstr2));
+  object_post((t_object *)x, "Fields:  %i - Positions: %i - Out: %i", x->fields, x->i_cut_cnt, x->o_cnt);
+  object_post((t_object *)x, "Substr:  %i - Outputs: %i", x->substr, x->outputs);
+  object_post((t_object *)x, "Delim:  %i - %s", x->delim, DSTR_CSTR(x->i_delim));
+  object_post((t_object *)x, "UTF-8:  %i - Index: %i", x->utf8, x->u_ix_cnt);
+  object_post((t_object *)x, "Negative:  %i", x->negative);
+  object_post((t_object *)x, "Alloc:  In: %i", DSTR_ALLOC(x->i_dstr));
   object_post((t_object *)x, "In: %s", DSTR_CSTR(x->i_dstr));
-  object_post((t_object *)x, "Left: %s", DSTR_CSTR(x->o_dstr1));
-  object_post((t_object *)x, "Right: %s", DSTR_CSTR(x->o_dstr2));
+  object_post((t_object *)x, "Left: %s", x->o_sym1->s_name);
+  object_post((t_object *)x, "Right: %s", x->o_sym2->s_name);
 }
 
 /****************************************************************
 *  The specific string action
+*
+*  The pieces are interned straight from the input string, and only for
+*  the enabled outlets.
 */
 void strcut_action(t_strcut *x)
 {
-  if (x->i_pos <= 0) {
-    dstr_empty(x->o_dstr1);
-    dstr_cpy_dstr(x->o_dstr2, x->i_dstr);
+  long beg;
+  long end;
+
+  if (x->fields) { strcut_fields(x); return; }
+
+  // Test that the t_dstr string is not NULL
+  if (DSTR_IS_NULL(x->i_dstr)) {
+    x->o_sym1 = gensym("<error>");
+    x->o_sym2 = gensym("<error>");
+    object_error((t_object *)x, "Allocation error. Reset the external.");
+    return;
   }
-  else if (x->i_pos < (long)DSTR_LENGTH(x->i_dstr)) {
-    dstr_rcpy_dstr(x->o_dstr1, x->i_dstr, 0, x->i_pos);
-    dstr_rcpy_dstr(x->o_dstr2, x->i_dstr, x->i_pos, DSTR_LENGTH(x->i_dstr) - x->i_pos);
 
-  } else {
-    dstr_cpy_dstr(x->o_dstr1, x->i_dstr);
-    dstr_empty(x->o_dstr2);
+  char *str = DSTR_CSTR(x->i_dstr);
+  long len = (long)DSTR_LENGTH(x->i_dstr);
+
+  if (x->substr) {
+    if (!(x->outputs & 1)) { return; }
+    strcut_range(x, x->i_cut_cnt ? x->i_cut_arr[0] : x->i_pos, (x->i_cut_cnt >= 2) ? x->i_cut_arr[1] : len, &beg, &end);
+    x->o_sym1 = str_gensym_span(str + beg, (t_dstr_int)(end - beg));
+    return;
   }
 
-  // Test that the t_dstr strings are not NULL
-  if (!DSTR_IS_NULL(x->i_dstr) && !DSTR_IS_NULL(x->o_dstr1) && !DSTR_IS_NULL(x->o_dstr2)) {
-    x->o_sym1 = gensym(DSTR_CSTR(x->o_dstr1));
-    x->o_sym2 = gensym(DSTR_CSTR(x->o_dstr2));
-  
+  // Cut at the position, or around the delimiter
+  long pos;
+  long next;
+  if (x->delim) {
+    t_dstr_int len_d = DSTR_LENGTH(x->i_delim);
+    t_dstr_int found = (x->delim == 1)
+      ? str_memmem(str, (t_dstr_int)len, DSTR_CSTR(x->i_delim), len_d)
+      : str_rmemmem(str, (t_dstr_int)len, DSTR_CSTR(x->i_delim), len_d);
+
+    if (len_d && (found != DSTR_LEN_ERR)) { pos = (long)found; next = pos + (long)len_d; }
+    else { pos = next = (x->delim == 1) ? len : 0; }
   } else {
-    x->o_sym1 = gensym("<error>");
-    x->o_sym2 = gensym("<error>");
+    pos = next = strcut_resolve(x, x->i_pos);
+  }
+
+  if (x->outputs & (x->mode ? 2 : 1)) { x->o_sym1 = str_gensym_span(str, (t_dstr_int)pos); }
+  if (x->outputs & (x->mode ? 1 : 2)) { x->o_sym2 = str_gensym_span(str + next, (t_dstr_int)(len - next)); }
+}
+
+/****************************************************************
+*  Cut the string into fields, at positions or from (start, length) pairs
+*
+*  The positions are clipped to the string, and to the previous position,
+*  so that the fields always cover the string in order.  With negative,
+*  negative positions and starts count from the end.  With utf8, they are
+*  resolved to byte offsets before cutting.
+*/
+void strcut_fields(t_strcut *x)
+{
+  char *str = DSTR_CSTR(x->i_dstr);
+  long len = (long)DSTR_LENGTH(x->i_dstr);
+  long *cut = x->i_cut_cnt ? x->i_cut_arr : &x->i_pos;
+  long cnt = x->i_cut_cnt ? x->i_cut_cnt : 1;
+  long beg = 0;
+  long end;
+
+  x->o_cnt = 0;
+  if (!(x->outputs & 1)) { return; }
+
+  if (DSTR_IS_NULL(x->i_dstr)) {
     object_error((t_object *)x, "Allocation error. Reset the external.");
+    return;
+  }
+
+  if (x->fields == 1) {
+    for (long i = 0; i < cnt; i++) {
+      end = strcut_resolve(x, cut[i]);
+      if (end < beg) { end = beg; }
+      strcut_add(x, str_gensym_span(str + beg, (t_dstr_int)(end - beg)));
+      beg = end;
+    }
+    strcut_add(x, str_gensym_span(str + beg, (t_dstr_int)(len - beg)));
+
+  } else {
+    for (long i = 0; i + 1 < cnt; i += 2) {
+      strcut_range(x, cut[i], cut[i + 1], &beg, &end);
+      strcut_add(x, str_gensym_span(str + beg, (t_dstr_int)(end - beg)));
+    }
   }
 }
 
+/****************************************************************
+*  Resolve a position to a byte offset in the input string
+*
+*  @return The byte offset, clipped to the string.
+*/
+long strcut_resolve(t_strcut *x, long pos)
+{
+  const char *str = DSTR_CSTR(x->i_dstr);
+  t_dstr_int len = DSTR_LENGTH(x->i_dstr);
+
+  if (!x->utf8) { return str_index(pos, (long)len, x->negative); }
+
+  if (x->utf8 == 2) { strcut_utf8_index(x); }
+
+  // Codepoints from the end
+  if ((pos < 0) && x->negative) { pos += (long)((x->utf8 == 2) ? x->u_cnt : str_utf8_count(str, len)); }
+  if (pos < 0) { pos = 0; }
+
+  // From the nearest indexed codepoint
+  if (x->u_ix_cnt && (x->utf8 == 2)) {
+    long k = pos / STR_UTF8_STEP;
+    if (k >= x->u_ix_cnt) { k = x->u_ix_cnt - 1; }
+    return (long)str_utf8_skip(str, len, x->u_ix[k], (t_dstr_int)(pos - k * STR_UTF8_STEP));
+  }
+
+  return (long)str_utf8_skip(str, len, 0, (t_dstr_int)pos);
+}
+
+/****************************************************************
+*  Resolve a (start, length) pair to a range of bytes of the input string
+*/
+void strcut_range(t_strcut *x, long start, long length, long *beg, long *end)
+{
+  if (!x->utf8) { str_range(start, length, (long)DSTR_LENGTH(x->i_dstr), x->negative, beg, end); return; }
+
+  *beg = strcut_resolve(x, start);
+  *end = (length >= 0)
+    ? (long)str_utf8_skip(DSTR_CSTR(x->i_dstr), DSTR_LENGTH(x->i_dstr), (t_dstr_int)*beg, (t_dstr_int)length)
+    : (x->negative ? strcut_resolve(x, length) : *beg);
+  if (*end < *beg) { *end = *beg; }
+}
+
+/****************************************************************
+*  Build the sparse index of the codepoints, if the input string changed
+*
+*  Without the memory for the index, the cuts scan from the start.
+*/
+void strcut_utf8_index(t_strcut *x)
+{
+  const char *str = DSTR_CSTR(x->i_dstr);
+  t_dstr_int len = DSTR_LENGTH(x->i_dstr);
+
+  if (!x->u_dirty) { return; }
+  x->u_dirty = 0;
+
+  x->u_cnt = str_utf8_count(str, len);
+  long cnt = (long)(x->u_cnt / STR_UTF8_STEP) + 1;
+
+  if (cnt > x->u_ix_max) {
+    t_dstr_int *ix = x->u_ix
+      ? (t_dstr_int *)sysmem_resizeptr(x->u_ix, sizeof(t_dstr_int) * cnt)
+      : (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * cnt);
+    if (!ix) {
+      object_error((t_object *)x, "utf8:  Allocation error.");
+      x->u_ix_cnt = 0;
+      return;
+    }
+    x->u_ix = ix;
+    x->u_ix_max = cnt;
+  }
+
+  x->u_ix[0] = 0;
+  for (long k = 1; k < cnt; k++) { x->u_ix[k] = str_utf8_skip(str, len, x->u_ix[k - 1], STR_UTF8_STEP); }
+  x->u_ix_cnt = cnt;
+}
+
+/****************************************************************
+*  Add a field to the output array
+*/
+void strcut_add(t_strcut *x, t_symbol *sym)
+{
+  if (x->o_cnt == STR_POS_MAX) { return; }
+
+  if (x->o_cnt == x->o_max) {
+    short max = (x->o_max < STR_POS_MAX / 2) ? 2 * x->o_max : STR_POS_MAX;
+    t_atom *arr = (t_atom *)sysmem_resizeptr(x->o_arr, sizeof(t_atom) * max);
+    if (!arr) { return; }
+    x->o_arr = arr;
+    x->o_max = max;
+  }
+
+  atom_setsym(x->o_arr + x->o_cnt++, sym);
+}
+
 /****************************************************************
 *  Output the strings
 */
 void strcut_output(t_strcut *x)
 {
+  if (x->fields) {
+    if (x->o_cnt) { outlet_anything(x->outl_any1, atom_getsym(x->o_arr), x->o_cnt - 1, x->o_arr + 1); }
+    return;
+  }
+
+  if (x->substr) {
+    if (x->outputs & 1) { outlet_anything(x->outl_any1, x->o_sym1, 0, NULL); }
+    return;
+  }
+
   switch(x->mode) {
   case 0:
-    outlet_anything(x->outl_any2, x->o_sym2, 0, NULL);
-    outlet_anything(x->outl_any1, x->o_sym1, 0, NULL);
+    if (x->outputs & 2) { outlet_anything(x->outl_any2, x->o_sym2, 0, NULL); }
+    if (x->outputs & 1) { outlet_anything(x->outl_any1, x->o_sym1, 0, NULL); }
     break;
   case 1:
-    outlet_anything(x->outl_any2, x->o_sym1, 0, NULL);
-    outlet_anything(x->outl_any1, x->o_sym2, 0, NULL);
+    if (x->outputs & 2) { outlet_anything(x->outl_any2, x->o_sym1, 0, NULL); }
+    if (x->outputs & 1) { outlet_anything(x->outl_any1, x->o_sym2, 0, NULL); }
     break;
   default: return;
   }
 }
 
+/****************************************************************
+*  Get the symbol of a span of a string, without copying it
+*
+*  The character following the span is set to null for gensym(), then
+*  restored:  the string must be writable, and hold a character at len.
+*/
+t_symbol *str_gensym_span(char *str, t_dstr_int len)
+{
+  char c = str[len];
+  t_symbol *sym;
+
+  str[len] = '\0';
+  sym = gensym(str);
+  str[len] = c;
+
+  return sym;
+}
+
+/****************************************************************
+*  Resolve a position in a string:  negative from the end with neg, then clipped
+*/
+long str_index(long pos, long len, long neg)
+{
+  if ((pos < 0) && neg) { pos += len; }
+  return (pos < 0) ? 0 : ((pos > len) ? len : pos);
+}
+
+/****************************************************************
+*  Resolve a (start, length) pair to a range of a string
+*
+*  With neg, a negative length gives the end from the end of the string,
+*  and without, an empty range.  The range is empty if the end is before
+*  the start.
+*/
+void str_range(long start, long length, long len, long neg, long *beg, long *end)
+{
+  *beg = str_index(start, len, neg);
+  *end = (length >= 0) ? ((length > len - *beg) ? len : *beg + length) : (neg ? str_index(length, len, 1) : *beg);
+  if (*end < *beg) { *end = *beg; }
+}
+
+/****************************************************************
+*  Search for a string in a string, filtering on the first and last characters
+*
+*  With SSE2, 16 candidate positions are tested at a time:  the bitmask of
+*  the positions where both the first and last characters match is computed,
+*  and only these candidates are compared in full.
+*
+*  @return The 0-based position of the first match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_memmem(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n)
+{
+  if (len_n == 0) { return 0; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  if (len_n == 1) {
+    const char *cp = (const char *)memchr(hay, ndl[0], len_h);
+    return cp ? (t_dstr_int)(cp - hay) : DSTR_LEN_ERR;
+  }
+
+  t_dstr_int last = len_n - 1;
+  t_dstr_int end = len_h - len_n;   // last candidate position
+  t_dstr_int i = 0;
+
+#ifdef STR_SSE2
+  __m128i first_16 = _mm_set1_epi8(ndl[0]);
+  __m128i last_16 = _mm_set1_epi8(ndl[last]);
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; i + 15 <= end; i += 16) {
+    mask = (unsigned long)_mm_movemask_epi8(_mm_and_si128(
+      _mm_cmpeq_epi8(first_16, _mm_loadu_si128((const __m128i *)(hay + i))),
+      _mm_cmpeq_epi8(last_16, _mm_loadu_si128((const __m128i *)(hay + i + last)))));
+
+    while (mask) {
+      _BitScanForward(&bit, mask);
+      if (!memcmp(hay + i + bit, ndl, len_n)) { return i + bit; }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  // Remaining candidates
+  for (; i <= end; i++) {
+    if ((hay[i] == ndl[0]) && (hay[i + last] == ndl[last]) && !memcmp(hay + i, ndl, len_n)) { return i; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Search backwards for a string in a string, with the same filter as str_memmem()
+*
+*  The candidate positions are tested from the end, 16 at a time with SSE2,
+*  taking the highest bit of each mask first.
+*
+*  @return The 0-based position of the last match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_rmemmem(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n)
+{
+  if (len_n == 0) { return len_h; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  t_dstr_int last = len_n - 1;
+  t_dstr_int cnt = len_h - len_n + 1;   // candidate positions below cnt
+  t_dstr_int i;
+
+#ifdef STR_SSE2
+  __m128i first_16 = _mm_set1_epi8(ndl[0]);
+  __m128i last_16 = _mm_set1_epi8(ndl[last]);
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; cnt >= 16; cnt -= 16) {
+    i = cnt - 16;
+    mask = (unsigned long)_mm_movemask_epi8(_mm_and_si128(
+      _mm_cmpeq_epi8(first_16, _mm_loadu_si128((const __m128i *)(hay + i))),
+      _mm_cmpeq_epi8(last_16, _mm_loadu_si128((const __m128i *)(hay + i + last)))));
+
+    while (mask) {
+      _BitScanReverse(&bit, mask);
+      if (!memcmp(hay + i + bit, ndl, len_n)) { return i + bit; }
+      mask &= ~(1UL << bit);
+    }
+  }
+#endif
+
+  // Remaining candidates
+  for (; cnt > 0; cnt--) {
+    i = cnt - 1;
+    if ((hay[i] == ndl[0]) && (hay[i + last] == ndl[last]) && !memcmp(hay + i, ndl, len_n)) { return i; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Count the codepoints of a UTF-8 string:  the bytes that are not 0x80 to 0xBF
+*
+*  With SSE2, the codepoints starting in each block of 16 bytes are counted
+*  in byte counters, summed with _mm_sad_epu8() before they overflow.
+*/
+t_dstr_int str_utf8_count(const char *str, t_dstr_int len)
+{
+  t_dstr_int cnt = 0;
+  t_dstr_int i = 0;
+
+#ifdef STR_SSE2
+  __m128i lim = _mm_set1_epi8(-65);   // 0xBF, the highest continuation byte
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc;
+  __m128i sum = zero;
+  long n;
+
+  while (i + 16 <= len) {
+    acc = zero;
+    for (n = 0; (n < 255) && (i + 16 <= len); n++, i += 16) {
+      acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i *)(str + i)), lim));
+    }
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(acc, zero));
+  }
+  cnt = (t_dstr_int)(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+#endif
+
+  for (; i < len; i++) { if ((str[i] & 0xC0) != 0x80) { cnt++; } }
+
+  return cnt;
+}
+
+/****************************************************************
+*  Skip a number of codepoints of a UTF-8 string
+*
+*  With SSE2, the blocks of 16 bytes where fewer codepoints start than
+*  remain to skip are passed over after counting them.
+*
+*  @param i The byte offset to start from, at the start of a codepoint.
+*  @param cnt The number of codepoints to skip.
+*
+*  @return The byte offset of the codepoint, or the length.
+*/
+t_dstr_int str_utf8_skip(const char *str, t_dstr_int len, t_dstr_int i, t_dstr_int cnt)
+{
+#ifdef STR_SSE2
+  __m128i lim = _mm_set1_epi8(-65);
+  __m128i one = _mm_set1_epi8(1);
+  __m128i zero = _mm_setzero_si128();
+  __m128i sad;
+  t_dstr_int n;
+
+  for (; i + 16 <= len; i += 16) {
+    sad = _mm_sad_epu8(_mm_and_si128(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i *)(str + i)), lim), one), zero);
+    n = (t_dstr_int)(_mm_cvtsi128_si32(sad) + _mm_cvtsi128_si32(_mm_srli_si128(sad, 8)));
+    if (n > cnt) { break; }
+    cnt -= n;
+  }
+#endif
+
+  for (; i < len; i++) {
+    if ((str[i] & 0xC0) != 0x80) {
+      if (!cnt) { return i; }
+      cnt--;
+    }
+  }
+
+  return len;
+}
+
 /****************************************************************
 *  Concatenate the content of an atom to an t_dstr string
 */
@@ -379,4 +958,82 @@ t_max_err str_fprecision_set(t_strcut *x, void *attr, long argc, t_atom *argv)
   strcat(x->format, "f");
 
   return MAX_ERR_NONE;
-}
\ No newline at end of file
+}
+
+/****************************************************************
+*  Custom setter for the fields attribute
+*/
+t_max_err str_fields_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->fields = (long)atom_getlong(argv); } else { x->fields = 0; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the mode attribute
+*/
+t_max_err str_mode_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->mode = (long)atom_getlong(argv); } else { x->mode = 0; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the substring attribute
+*/
+t_max_err str_substr_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->substr = (long)atom_getlong(argv); } else { x->substr = 0; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the outputs attribute
+*/
+t_max_err str_outputs_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->outputs = (long)atom_getlong(argv); } else { x->outputs = 3; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the delimiter attribute
+*/
+t_max_err str_delim_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->delim = (long)atom_getlong(argv); } else { x->delim = 0; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the UTF-8 attribute
+*/
+t_max_err str_utf8_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->utf8 = (long)atom_getlong(argv); } else { x->utf8 = 0; }
+  x->u_dirty = 1;
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the negative attribute
+*/
+t_max_err str_negative_set(t_strcut *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->negative = (long)atom_getlong(argv); } else { x->negative = 0; }
+
+  strcut_action(x);
+  return MAX_ERR_NONE;
+}
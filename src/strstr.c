@@ -8,6 +8,47 @@
 *    - the new style Max object,
 *    - dynamic strings,
 *    - attributes.
+*
+*  The search uses the string lengths, and is binary safe.  Short strings are
+*  searched for with an SSE2 filter on their first and last characters,
+*  16 positions at a time.  Long strings use a Horspool skip table, computed
+*  from the searched string only when it changes, so that a fixed string
+*  can be searched for in many strings without being processed again.
+*
+*  The report attribute selects the output:  the first position (0),
+*  the list of all positions (1), or the number of matches (2),
+*  with overlapping matches if the overlap attribute is set.
+*
+*  The from attribute skips characters at the start of the string, or at
+*  the end with reverse 1, in which case the string is searched backwards.
+*  The nth attribute selects the occurrence reported as the first position.
+*  These three attributes only apply to the exact search of a single string.
+*
+*  Indexed mode (indexed 1):  a suffix array of the string to search in is
+*  built when it changes, by prefix doubling.  A search is then a binary
+*  search for the range of the suffixes starting with the searched string,
+*  in O(m log n).  The first match is the smallest position in the range,
+*  and only the list of all the positions sorts the whole range.
+*  It applies to the case sensitive search of a single string, and the
+*  memory used is shown by the post message.
+*
+*  Multi mode (multi 1):  the searched string is a space separated list of
+*  patterns, compiled into an Aho-Corasick automaton when it changes.
+*  All patterns are searched for in a single pass, and matches are
+*  reported as pairs of 1-based pattern index and position.
+*
+*  Case insensitive search (icase 1):  ASCII letters are folded on the fly,
+*  in the SSE2 filter and in the comparison, without copying the strings.
+*  With icase 2, the Latin-1 letters encoded in UTF-8 (U+00C0 to U+00DE) are
+*  also folded.  Multi mode only folds ASCII letters.
+*
+*  Approximate search (errors k):  finds the first match within edit distance
+*  k, with the bit-parallel algorithm of Myers, on as many 64-bit words as the
+*  searched string needs.  The match is extended while the distance decreases,
+*  and is reported as a pair of position and distance.  Approximate matches
+*  never overlap, and only ASCII letters are folded.  The distance is kept
+*  below the length of the searched string, as deleting all of it would
+*  match an empty substring anywhere.
 */
 
 /****************************************************************
@@ -17,9 +58,17 @@
 #include "ext_obex.h"
 #include "dstring.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STR_SSE2 1
+#include <intrin.h>
+#endif
+
 /****************************************************************
 *  Preprocessor
 */
+#define STR_HORSPOOL_MIN 32   // length from which the skip table is used
+#define STR_POS_ALLOC 16
+#define STR_POS_MAX   32766   // outlet_list() takes a short count, even for pairs
 
 /****************************************************************
 *  Max object structure
@@ -30,13 +79,50 @@ typedef struct _strstr
 
   void *inl_proxy;
   long  inl_proxy_ind;
-  void *outl_int;
+  void *outl_any;
   
-  t_dstr i_dstr1;
-  t_dstr i_dstr2;
-  long   o_pos;
+  t_dstr  i_dstr1;
+  t_dstr  i_dstr2;
+  long    o_pos;
+  long    o_cnt;
+  t_atom *o_pos_arr;
+  short   o_pos_max;
+  short   o_pos_cnt;
+
+  t_dstr_int s_skip[256];
+  t_dstr_int s_rskip[256];      // skip table for the reverse search
+  char       s_dirty;
+
+  long          ac_cls[256];    // byte to character class
+  long          ac_cls_cnt;
+  long          ac_state_cnt;
+  long         *ac_next;        // transitions, ac_state_cnt * ac_cls_cnt
+  long         *ac_pat;         // 1-based pattern index ending at a state, or 0
+  long         *ac_dict;        // next state with a pattern on the fail chain, or 0
+  t_dstr_int   *ac_depth;
+
+  long              fz_blk_cnt;
+  unsigned __int64 *fz_peq;     // match bitmasks of each byte, 256 * fz_blk_cnt
+  unsigned __int64 *fz_rpeq;    // same for the reversed string
+  unsigned __int64 *fz_vp;      // positive vertical deltas, fz_blk_cnt
+  unsigned __int64 *fz_vn;      // negative vertical deltas, fz_blk_cnt
+
+  t_dstr_int   *sa_arr;         // suffix array of the string to search in
+  t_dstr_int   *sa_tmp;         // positions of the matches
+  t_dstr_int    sa_len;
+  t_dstr_int    sa_max;
+  char          sa_dirty;
 
   long  mode;
+  long  report;
+  long  overlap;
+  long  multi;
+  long  icase;
+  long  errors;
+  long  from;
+  long  reverse;
+  long  nth;
+  long  indexed;
   long  fprecision;
   char  format[6];
 
@@ -47,6 +133,14 @@ typedef struct _strstr
 */
 static t_class *strstr_class = NULL;
 
+/****************************************************************
+*  Global folding tables for the filters, for each icase value
+*
+*  The tables fold the Latin-1 continuation bytes regardless of the
+*  preceding byte, so they can only be used to filter candidates.
+*/
+static unsigned char str_fold[3][256];
+
 /****************************************************************
 *  Function declarations
 */
@@ -62,14 +156,54 @@ void  strstr_anything (t_strstr *x, t_symbol *sym, long argc, t_atom *argv);
 void  strstr_set      (t_strstr *x, t_symbol *sym, long argc, t_atom *argv);
 void  strstr_post     (t_strstr *x);
 
+void  strstr_input    (t_strstr *x, t_dstr dstr, char output);
 void  strstr_action   (t_strstr *x);
+void  strstr_prepare  (t_strstr *x, t_dstr needle);
+void  strstr_add      (t_strstr *x, t_atom_long n);
+t_dstr_int strstr_find(t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n);
+void  strstr_ac_build (t_strstr *x, t_dstr needle);
+void  strstr_ac_search(t_strstr *x, t_dstr hay);
+void  strstr_ac_free  (t_strstr *x);
+void  strstr_fz_build (t_strstr *x, t_dstr needle);
+void  strstr_fz_search(t_strstr *x, t_dstr hay, t_dstr_int len_n);
+void  strstr_fz_free  (t_strstr *x);
+void  strstr_sa_build (t_strstr *x, t_dstr hay);
+void  strstr_sa_search(t_strstr *x, t_dstr hay, t_dstr ndl);
+void  strstr_sa_free  (t_strstr *x);
 void  strstr_output   (t_strstr *x);
 
+t_dstr_int str_search        (t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n);
+t_dstr_int str_rsearch       (t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n);
+t_dstr_int str_memmem        (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, long icase);
+t_dstr_int str_rmemmem       (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, long icase);
+t_dstr_int str_horspool      (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, const t_dstr_int *skip, long icase);
+t_dstr_int str_rhorspool     (const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, const t_dstr_int *skip, long icase);
+short     str_equal          (const char *str1, const char *str2, t_dstr_int len, long icase);
+void      str_fold_init      (void);
+#ifdef STR_SSE2
+__m128i   str_fold_sse2      (__m128i v, long icase);
+#endif
+t_dstr_int str_myers_end     (t_strstr *x, const unsigned char *hay, t_dstr_int len_h, t_dstr_int len_n, long max, long *dist);
+t_dstr_int str_myers_start   (t_strstr *x, const unsigned char *hay, t_dstr_int end, t_dstr_int len_n, long dist);
+int       str_sa_cmp         (const char *hay, t_dstr_int len_h, t_dstr_int pos, const char *ndl, t_dstr_int len_n);
+int       str_pos_cmp        (const void *pos1, const void *pos2);
+int       str_pos_rcmp       (const void *pos1, const void *pos2);
+void      str_pos_select     (t_dstr_int *arr, t_dstr_int cnt, t_dstr_int k, long rev);
+long      str_myers_advance  (unsigned __int64 *vp, unsigned __int64 *vn, const unsigned __int64 *eq, long blk_cnt, unsigned __int64 last, long hin);
 t_dstr    str_proxy_to_dstr  (t_strstr *x);
 t_dstr    str_cat_atom       (t_strstr *x, t_dstr dstr, t_atom *atom);
 t_dstr    str_cat_args       (t_strstr *x, t_dstr dstr, long argc, t_atom *argv);
 t_max_err str_mode_set       (t_strstr *x, void *attr, long argc, t_atom *argv);
 t_max_err str_fprecision_set (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_report_set     (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_overlap_set    (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_multi_set      (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_icase_set      (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_errors_set     (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_from_set       (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_reverse_set    (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_nth_set        (t_strstr *x, void *attr, long argc, t_atom *argv);
+t_max_err str_indexed_set    (t_strstr *x, void *attr, long argc, t_atom *argv);
 
 
 /****************************************************************
@@ -112,6 +246,80 @@ void ext_main(void *r)
   CLASS_ATTR_SELFSAVE(c, "fprecision", 0);
   CLASS_ATTR_ACCESSORS(c, "fprecision", NULL, str_fprecision_set);
 
+  CLASS_ATTR_LONG(c, "report", 0, t_strstr, report);
+  CLASS_ATTR_ORDER(c, "report", 0, "3");
+  CLASS_ATTR_LABEL(c, "report", 0, "report first, all or count");
+  CLASS_ATTR_FILTER_CLIP(c, "report", 0, 2);
+  CLASS_ATTR_SAVE(c, "report", 0);
+  CLASS_ATTR_SELFSAVE(c, "report", 0);
+  CLASS_ATTR_ACCESSORS(c, "report", NULL, str_report_set);
+
+  CLASS_ATTR_LONG(c, "overlap", 0, t_strstr, overlap);
+  CLASS_ATTR_ORDER(c, "overlap", 0, "4");
+  CLASS_ATTR_LABEL(c, "overlap", 0, "overlapping matches");
+  CLASS_ATTR_FILTER_CLIP(c, "overlap", 0, 1);
+  CLASS_ATTR_SAVE(c, "overlap", 0);
+  CLASS_ATTR_SELFSAVE(c, "overlap", 0);
+  CLASS_ATTR_ACCESSORS(c, "overlap", NULL, str_overlap_set);
+
+  CLASS_ATTR_LONG(c, "multi", 0, t_strstr, multi);
+  CLASS_ATTR_ORDER(c, "multi", 0, "5");
+  CLASS_ATTR_LABEL(c, "multi", 0, "multiple patterns");
+  CLASS_ATTR_FILTER_CLIP(c, "multi", 0, 1);
+  CLASS_ATTR_SAVE(c, "multi", 0);
+  CLASS_ATTR_SELFSAVE(c, "multi", 0);
+  CLASS_ATTR_ACCESSORS(c, "multi", NULL, str_multi_set);
+
+  CLASS_ATTR_LONG(c, "icase", 0, t_strstr, icase);
+  CLASS_ATTR_ORDER(c, "icase", 0, "6");
+  CLASS_ATTR_LABEL(c, "icase", 0, "ignore case");
+  CLASS_ATTR_FILTER_CLIP(c, "icase", 0, 2);
+  CLASS_ATTR_SAVE(c, "icase", 0);
+  CLASS_ATTR_SELFSAVE(c, "icase", 0);
+  CLASS_ATTR_ACCESSORS(c, "icase", NULL, str_icase_set);
+
+  CLASS_ATTR_LONG(c, "errors", 0, t_strstr, errors);
+  CLASS_ATTR_ORDER(c, "errors", 0, "7");
+  CLASS_ATTR_LABEL(c, "errors", 0, "maximum edit distance");
+  CLASS_ATTR_FILTER_CLIP(c, "errors", 0, 255);
+  CLASS_ATTR_SAVE(c, "errors", 0);
+  CLASS_ATTR_SELFSAVE(c, "errors", 0);
+  CLASS_ATTR_ACCESSORS(c, "errors", NULL, str_errors_set);
+
+  CLASS_ATTR_LONG(c, "from", 0, t_strstr, from);
+  CLASS_ATTR_ORDER(c, "from", 0, "8");
+  CLASS_ATTR_LABEL(c, "from", 0, "start offset");
+  CLASS_ATTR_FILTER_MIN(c, "from", 0);
+  CLASS_ATTR_SAVE(c, "from", 0);
+  CLASS_ATTR_SELFSAVE(c, "from", 0);
+  CLASS_ATTR_ACCESSORS(c, "from", NULL, str_from_set);
+
+  CLASS_ATTR_LONG(c, "reverse", 0, t_strstr, reverse);
+  CLASS_ATTR_ORDER(c, "reverse", 0, "9");
+  CLASS_ATTR_LABEL(c, "reverse", 0, "search from the end");
+  CLASS_ATTR_FILTER_CLIP(c, "reverse", 0, 1);
+  CLASS_ATTR_SAVE(c, "reverse", 0);
+  CLASS_ATTR_SELFSAVE(c, "reverse", 0);
+  CLASS_ATTR_ACCESSORS(c, "reverse", NULL, str_reverse_set);
+
+  CLASS_ATTR_LONG(c, "nth", 0, t_strstr, nth);
+  CLASS_ATTR_ORDER(c, "nth", 0, "10");
+  CLASS_ATTR_LABEL(c, "nth", 0, "occurrence");
+  CLASS_ATTR_FILTER_MIN(c, "nth", 1);
+  CLASS_ATTR_SAVE(c, "nth", 0);
+  CLASS_ATTR_SELFSAVE(c, "nth", 0);
+  CLASS_ATTR_ACCESSORS(c, "nth", NULL, str_nth_set);
+
+  CLASS_ATTR_LONG(c, "indexed", 0, t_strstr, indexed);
+  CLASS_ATTR_ORDER(c, "indexed", 0, "11");
+  CLASS_ATTR_LABEL(c, "indexed", 0, "index the string");
+  CLASS_ATTR_FILTER_CLIP(c, "indexed", 0, 1);
+  CLASS_ATTR_SAVE(c, "indexed", 0);
+  CLASS_ATTR_SELFSAVE(c, "indexed", 0);
+  CLASS_ATTR_ACCESSORS(c, "indexed", NULL, str_indexed_set);
+
+  str_fold_init();
+
   class_register(CLASS_BOX, c);
   strstr_class = c;
 }
@@ -133,7 +341,7 @@ void *strstr_new(t_symbol *sym, long argc, t_atom *argv)
   // Set inlets, outlets, and proxy
   x->inl_proxy_ind = 0;
   x->inl_proxy = proxy_new((t_object *)x, 1, &x->inl_proxy_ind);
-  x->outl_int = intout((t_object *)x);
+  x->outl_any = outlet_new((t_object *)x, NULL);
 
   // Set the left string buffer
   x->i_dstr1 = dstr_new();
@@ -144,13 +352,21 @@ void *strstr_new(t_symbol *sym, long argc, t_atom *argv)
     x->i_dstr2 = str_cat_atom(x, x->i_dstr2, argv);
   }
 
+  // Set the array of positions
+  x->o_pos_max = STR_POS_ALLOC;
+  x->o_pos_arr = (t_atom *)sysmem_newptr(sizeof(t_atom) * x->o_pos_max);
+
   // Test the string buffers
-  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2) || !x->o_pos_arr) {
     object_error((t_object *)x, "Allocation error.");
     strstr_free(x);
     return NULL;
   }
 
+  // The skip table is computed, and the string indexed, on the first search
+  x->s_dirty = 1;
+  x->sa_dirty = 1;
+
   // Second argument:  mode
   long mode = 0;
   if ((argc >= 2) && (attr_args_offset((short)argc, argv) >= 2)) {
@@ -165,8 +381,13 @@ void *strstr_new(t_symbol *sym, long argc, t_atom *argv)
   // Set the float precision
   object_attr_setlong(x, gensym("fprecision"), 6);
 
+  // Report the first occurrence
+  object_attr_setlong(x, gensym("nth"), 1);
+
   // Set the remaining variables
   x->o_pos = -1;
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
 
   // Process the attributes
   attr_args_process(x, (short)argc, argv);
@@ -181,6 +402,10 @@ void strstr_free(t_strstr *x)
 {
   dstr_free(&x->i_dstr1);
   dstr_free(&x->i_dstr2);
+  if (x->o_pos_arr) { sysmem_freeptr(x->o_pos_arr); }
+  strstr_ac_free(x);
+  strstr_fz_free(x);
+  strstr_sa_free(x);
   freeobject((t_object *)x->inl_proxy);
 }
 
@@ -200,8 +425,8 @@ void strstr_assist(t_strstr *x, void *b, long msg, long arg, char *dst)
   case ASSIST_OUTLET:
     switch (arg) {
     case 0:
-      if (x->mode == 0) { sprintf(dst, "position of s2 in s1 (int)"); }
-      else { sprintf(dst, "position of s1 in s2 (int)"); }
+      if (x->mode == 0) { sprintf(dst, "position of s2 in s1 (int / list)"); }
+      else { sprintf(dst, "position of s1 in s2 (int / list)"); }
       break;
     default: break;
     }
@@ -225,8 +450,7 @@ void strstr_int(t_strstr *x, long n)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_int(dstr, n);
-  strstr_action(x);
-  if (dstr == x->i_dstr1) { strstr_output(x); }
+  strstr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -237,8 +461,7 @@ void strstr_float(t_strstr *x, double f)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_printf(dstr, x->format, f);
-  strstr_action(x);
-  if (dstr == x->i_dstr1) { strstr_output(x); }
+  strstr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -250,8 +473,7 @@ void strstr_list(t_strstr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strstr_action(x);
-  if (dstr == x->i_dstr1) { strstr_output(x); }
+  strstr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -263,8 +485,7 @@ void strstr_anything(t_strstr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_cpy_cstr(dstr, sym->s_name);
   str_cat_args(x, dstr, argc, argv);
-  strstr_action(x);
-  if (dstr == x->i_dstr1) { strstr_output(x); }
+  strstr_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -276,7 +497,7 @@ void strstr_set(t_strstr *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strstr_action(x);
+  strstr_input(x, dstr, 0);
 }
 
 /****************************************************************
@@ -285,13 +506,36 @@ void strstr_set(t_strstr *x, t_symbol *sym, long argc, t_atom *argv)
 void strstr_post(t_strstr *x)
 {
   object_post((t_object *)x, "Mode:  %i", x->mode);
+  object_post((t_object *)x, "Report:  %i - Overlap: %i", x->report, x->overlap);
+  object_post((t_object *)x, "Multi:  %i - States: %i - Classes: %i", x->multi, x->ac_state_cnt, x->ac_cls_cnt);
+  object_post((t_object *)x, "Ignore case:  %i", x->icase);
+  object_post((t_object *)x, "Errors:  %i - Blocks: %i", x->errors, x->fz_blk_cnt);
+  object_post((t_object *)x, "From:  %i - Reverse: %i - Nth: %i", x->from, x->reverse, x->nth);
+  object_post((t_object *)x, "Indexed:  %i - Length: %i - Memory: %i bytes",
+    x->indexed, x->sa_len, x->sa_arr ? (long)(2 * sizeof(t_dstr_int) * x->sa_max) : 0);
   object_post((t_object *)x, "Float precision:  %i", x->fprecision);
+  object_post((t_object *)x, "Matches:  %i - Alloc: %i", x->o_cnt, x->o_pos_max);
   object_post((t_object *)x, "Alloc:  Left: %i - Right: %i",
     DSTR_ALLOC(x->i_dstr1), DSTR_ALLOC(x->i_dstr2));
   object_post((t_object *)x, "Left: %s", DSTR_CSTR(x->i_dstr1));
   object_post((t_object *)x, "Right: %s", DSTR_CSTR(x->i_dstr2));
 }
 
+/****************************************************************
+*  Process a new input, invalidating the skip table or the index of the modified string
+*
+*  @param dstr The string buffer that was just modified.
+*  @param output Whether the input should trigger an output.
+*/
+void strstr_input(t_strstr *x, t_dstr dstr, char output)
+{
+  if (dstr == ((x->mode == 0) ? x->i_dstr2 : x->i_dstr1)) { x->s_dirty = 1; }
+  else { x->sa_dirty = 1; }
+
+  strstr_action(x);
+  if (output && (dstr == x->i_dstr1)) { strstr_output(x); }
+}
+
 /****************************************************************
 *  The specific string action
 */
@@ -300,27 +544,1068 @@ void strstr_action(t_strstr *x)
   // Test that the t_dstr strings are not NULL
   if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
     x->o_pos = -1;
+    x->o_cnt = 0;
+    x->o_pos_cnt = 0;
     object_error((t_object *)x, "Allocation error. Reset the external.");
     return;
   }
 
-  char *cp;
-  if (x->mode == 0) {
-    cp = strstr(DSTR_CSTR(x->i_dstr1), DSTR_CSTR(x->i_dstr2));
-    x->o_pos = cp ? (long)(cp - DSTR_CSTR(x->i_dstr1) + 1) : -1;
+  t_dstr hay = (x->mode == 0) ? x->i_dstr1 : x->i_dstr2;
+  t_dstr ndl = (x->mode == 0) ? x->i_dstr2 : x->i_dstr1;
+
+  if (x->s_dirty) { strstr_prepare(x, ndl); }
+
+  if (x->multi) { strstr_ac_search(x, hay); return; }
+
+  t_dstr_int len_h = DSTR_LENGTH(hay);
+  t_dstr_int len_n = DSTR_LENGTH(ndl);
+
+  if (x->errors && len_n) { strstr_fz_search(x, hay, len_n); return; }
+
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
+
+  // Without the index, because of an allocation error, fall back to the scan
+  if (x->indexed && len_n && !x->icase) {
+    if (x->sa_dirty) { strstr_sa_build(x, hay); }
+    if (x->sa_arr) { strstr_sa_search(x, hay, ndl); return; }
+  }
+
+  if (x->report == 0) {
+    t_dstr_int pos = strstr_find(x, DSTR_CSTR(hay), len_h, DSTR_CSTR(ndl), len_n);
+    x->o_pos = (pos != DSTR_LEN_ERR) ? (long)(pos + 1) : -1;
+    return;
+  }
+
+  // Resume the search after each match, in a single pass over the string
+  t_dstr_int step = (x->overlap || (len_n == 0)) ? 1 : len_n;
+  t_dstr_int beg = ((t_dstr_int)x->from < len_h) ? (t_dstr_int)x->from : len_h;
+  t_dstr_int pos = str_search(x, DSTR_CSTR(hay) + beg, len_h - beg, DSTR_CSTR(ndl), len_n);
+  if (pos != DSTR_LEN_ERR) { pos += beg; }
+  x->o_pos = (pos != DSTR_LEN_ERR) ? (long)(pos + 1) : -1;
+
+  while (pos != DSTR_LEN_ERR) {
+    x->o_cnt++;
+    if (x->report == 1) { strstr_add(x, (t_atom_long)pos + 1); }
+
+    beg = pos + step;
+    if (beg > len_h) { break; }
+    pos = str_search(x, DSTR_CSTR(hay) + beg, len_h - beg, DSTR_CSTR(ndl), len_n);
+    if (pos != DSTR_LEN_ERR) { pos += beg; }
+  }
+}
+
+/****************************************************************
+*  Find the nth occurrence from the start offset, forwards or backwards
+*
+*  @return The 0-based position of the occurrence, or DSTR_LEN_ERR.
+*/
+t_dstr_int strstr_find(t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n)
+{
+  t_dstr_int step = (x->overlap || (len_n == 0)) ? 1 : len_n;
+  t_dstr_int off = ((t_dstr_int)x->from < len_h) ? (t_dstr_int)x->from : len_h;
+  t_dstr_int pos = DSTR_LEN_ERR;
+
+  if (!x->reverse) {
+    t_dstr_int beg = off;
+
+    for (long i = 0; i < x->nth; i++) {
+      if (i) {
+        beg = pos + step;
+        if (beg > len_h) { return DSTR_LEN_ERR; }
+      }
+      pos = str_search(x, hay + beg, len_h - beg, ndl, len_n);
+      if (pos == DSTR_LEN_ERR) { return DSTR_LEN_ERR; }
+      pos += beg;
+    }
+
+  } else {
+    // The next occurrence has to end before the limit
+    t_dstr_int lim = len_h - off;
+
+    for (long i = 0; i < x->nth; i++) {
+      if (i) {
+        if (pos + len_n < step) { return DSTR_LEN_ERR; }
+        lim = pos + len_n - step;
+      }
+      pos = str_rsearch(x, hay, lim, ndl, len_n);
+      if (pos == DSTR_LEN_ERR) { return DSTR_LEN_ERR; }
+    }
+  }
+
+  return pos;
+}
+
+/****************************************************************
+*  Store an int for output, growing the array if necessary
+*/
+void strstr_add(t_strstr *x, t_atom_long n)
+{
+  if (x->o_pos_cnt == STR_POS_MAX) { return; }
+
+  if (x->o_pos_cnt == x->o_pos_max) {
+    short max = (x->o_pos_max < STR_POS_MAX / 2) ? 2 * x->o_pos_max : STR_POS_MAX;
+    t_atom *arr = (t_atom *)sysmem_resizeptr(x->o_pos_arr, sizeof(t_atom) * max);
+    if (!arr) { return; }
+    x->o_pos_arr = arr;
+    x->o_pos_max = max;
+  }
+
+  atom_setlong(x->o_pos_arr + x->o_pos_cnt++, n);
+}
+
+/****************************************************************
+*  Compute the Horspool skip tables of the searched string
+*
+*  For each character, the skip is the distance from its last occurrence
+*  in the searched string, excluding the last position, to the end.
+*  For the reverse search, the skip is the distance from its first
+*  occurrence, excluding the first position, to the start.
+*/
+void strstr_prepare(t_strstr *x, t_dstr needle)
+{
+  if (x->multi) { strstr_ac_build(x, needle); x->s_dirty = 0; return; }
+  if (x->errors) { strstr_fz_build(x, needle); x->s_dirty = 0; return; }
+
+  t_dstr_int len = DSTR_LENGTH(needle);
+  const unsigned char *ndl = (const unsigned char *)DSTR_CSTR(needle);
+  const unsigned char *fold = str_fold[x->icase];
+
+  // The table is indexed by folded characters
+  for (int c = 0; c < 256; c++) { x->s_skip[c] = len; }
+  for (t_dstr_int i = 0; i + 1 < len; i++) { x->s_skip[fold[ndl[i]]] = len - 1 - i; }
+
+  for (int c = 0; c < 256; c++) { x->s_rskip[c] = len; }
+  for (t_dstr_int i = len; i > 1; i--) { x->s_rskip[fold[ndl[i - 1]]] = i - 1; }
+
+  x->s_dirty = 0;
+}
+
+/****************************************************************
+*  Compile the list of patterns into an Aho-Corasick automaton
+*
+*  The automaton is stored as a complete transition table over the classes
+*  of the bytes used in the patterns, so that the search does a single
+*  lookup per byte.
+*/
+void strstr_ac_build(t_strstr *x, t_dstr needle)
+{
+  const unsigned char *ndl = (const unsigned char *)DSTR_CSTR(needle);
+  t_dstr_int len = DSTR_LENGTH(needle);
+
+  strstr_ac_free(x);
+
+  // Character classes:  0 for the bytes that are not in any pattern
+  const unsigned char *fold = str_fold[x->icase ? 1 : 0];
+  memset(x->ac_cls, 0, sizeof(x->ac_cls));
+  x->ac_cls_cnt = 1;
+  for (t_dstr_int i = 0; i < len; i++) {
+    if ((ndl[i] != ' ') && !x->ac_cls[fold[ndl[i]]]) { x->ac_cls[fold[ndl[i]]] = x->ac_cls_cnt++; }
+  }
+
+  // Upper case letters share the class of their lower case
+  for (int c = 0; c < 256; c++) { x->ac_cls[c] = x->ac_cls[fold[c]]; }
+
+  // Allocate for the maximum number of states:  the root and one per character
+  long max = 1 + (long)len;
+  long k = x->ac_cls_cnt;
+  x->ac_next = (long *)sysmem_newptrclear(sizeof(long) * max * k);
+  x->ac_pat = (long *)sysmem_newptrclear(sizeof(long) * max);
+  x->ac_dict = (long *)sysmem_newptrclear(sizeof(long) * max);
+  x->ac_depth = (t_dstr_int *)sysmem_newptrclear(sizeof(t_dstr_int) * max);
+  long *fail = (long *)sysmem_newptrclear(sizeof(long) * max);
+  long *queue = (long *)sysmem_newptr(sizeof(long) * max);
+
+  if (!x->ac_next || !x->ac_pat || !x->ac_dict || !x->ac_depth || !fail || !queue) {
+    object_error((t_object *)x, "multi:  Allocation error.");
+    strstr_ac_free(x);
+    if (fail) { sysmem_freeptr(fail); }
+    if (queue) { sysmem_freeptr(queue); }
+    return;
+  }
+
+  // Build the trie, with 0 as the root and as "no transition"
+  long cnt = 1;
+  long pat = 0;
+  long st;
+  t_dstr_int i = 0;
+
+  while (i < len) {
+    while ((i < len) && (ndl[i] == ' ')) { i++; }
+    if (i == len) { break; }
+
+    pat++;
+    st = 0;
+    for (; (i < len) && (ndl[i] != ' '); i++) {
+      long *next = x->ac_next + st * k + x->ac_cls[ndl[i]];
+      if (!*next) {
+        x->ac_depth[cnt] = x->ac_depth[st] + 1;
+        *next = cnt++;
+      }
+      st = *next;
+    }
+    if (!x->ac_pat[st]) { x->ac_pat[st] = pat; }
+  }
+  x->ac_state_cnt = cnt;
+
+  // Breadth first:  set the fail and dictionary links and complete the transitions
+  long head = 0;
+  long tail = 0;
+  for (long c = 0; c < k; c++) {
+    if (x->ac_next[c]) { queue[tail++] = x->ac_next[c]; }
+  }
+
+  while (head < tail) {
+    st = queue[head++];
+    x->ac_dict[st] = x->ac_pat[fail[st]] ? fail[st] : x->ac_dict[fail[st]];
+
+    for (long c = 0; c < k; c++) {
+      long *next = x->ac_next + st * k + c;
+      if (*next) {
+        fail[*next] = x->ac_next[fail[st] * k + c];
+        queue[tail++] = *next;
+      } else {
+        *next = x->ac_next[fail[st] * k + c];
+      }
+    }
+  }
+
+  sysmem_freeptr(fail);
+  sysmem_freeptr(queue);
+}
+
+/****************************************************************
+*  Search for all the patterns in a single pass over the string
+*
+*  Matches are found by increasing end position, and for the same end
+*  by decreasing length.  Without overlap, a match is skipped if it starts
+*  before the end of the previous one.
+*
+*  The first match (report 0) is the one with the leftmost start, and the
+*  longest one for the same start.  As the depth of the current state bounds
+*  the start of the matches still to come, the scan stops as soon as none can
+*  start at or before the best one.
+*/
+void strstr_ac_search(t_strstr *x, t_dstr hay)
+{
+  const unsigned char *h = (const unsigned char *)DSTR_CSTR(hay);
+  t_dstr_int len = DSTR_LENGTH(hay);
+  t_dstr_int beg;
+  t_dstr_int next_beg = 0;
+  long k = x->ac_cls_cnt;
+  long st = 0;
+
+  x->o_pos = -1;
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
+  if (!x->ac_next) { return; }
+
+  if (x->report == 0) {
+    long pat = 0;
+    t_dstr_int best = 0;
+
+    for (t_dstr_int i = 0; i < len; i++) {
+      st = x->ac_next[st * k + x->ac_cls[h[i]]];
+      if (pat && (i + 1 - x->ac_depth[st] > best)) { break; }
+
+      for (long t = x->ac_pat[st] ? st : x->ac_dict[st]; t; t = x->ac_dict[t]) {
+        beg = i + 1 - x->ac_depth[t];
+        if (!pat || (beg <= best)) { pat = x->ac_pat[t]; best = beg; }
+      }
+    }
+
+    if (pat) {
+      x->o_cnt = 1;
+      x->o_pos = (long)best + 1;
+      strstr_add(x, pat);
+      strstr_add(x, (t_atom_long)best + 1);
+    }
+    return;
+  }
+
+  for (t_dstr_int i = 0; i < len; i++) {
+    st = x->ac_next[st * k + x->ac_cls[h[i]]];
+
+    for (long t = x->ac_pat[st] ? st : x->ac_dict[st]; t; t = x->ac_dict[t]) {
+      beg = i + 1 - x->ac_depth[t];
+      if (!x->overlap && (beg < next_beg)) { continue; }
+      next_beg = i + 1;
+
+      x->o_cnt++;
+      if (x->report != 2) {
+        strstr_add(x, x->ac_pat[t]);
+        strstr_add(x, (t_atom_long)beg + 1);
+      }
+    }
+  }
+}
+
+/****************************************************************
+*  Free the Aho-Corasick automaton
+*/
+void strstr_ac_free(t_strstr *x)
+{
+  if (x->ac_next) { sysmem_freeptr(x->ac_next); }
+  if (x->ac_pat) { sysmem_freeptr(x->ac_pat); }
+  if (x->ac_dict) { sysmem_freeptr(x->ac_dict); }
+  if (x->ac_depth) { sysmem_freeptr(x->ac_depth); }
+
+  x->ac_next = NULL;
+  x->ac_pat = NULL;
+  x->ac_dict = NULL;
+  x->ac_depth = NULL;
+  x->ac_state_cnt = 0;
+}
+
+/****************************************************************
+*  Compute the match bitmasks of the searched string for approximate search
+*
+*  Bit i of the mask of a byte is set if the byte matches the character i
+*  of the string, in blocks of 64 bits.  The bitmasks of the reversed string
+*  are used to find where a match starts.
+*/
+void strstr_fz_build(t_strstr *x, t_dstr needle)
+{
+  const unsigned char *ndl = (const unsigned char *)DSTR_CSTR(needle);
+  t_dstr_int len = DSTR_LENGTH(needle);
+
+  strstr_fz_free(x);
+  if (len == 0) { return; }
+
+  long cnt = (long)((len + 63) / 64);
+  x->fz_peq = (unsigned __int64 *)sysmem_newptrclear(sizeof(unsigned __int64) * 256 * cnt);
+  x->fz_rpeq = (unsigned __int64 *)sysmem_newptrclear(sizeof(unsigned __int64) * 256 * cnt);
+  x->fz_vp = (unsigned __int64 *)sysmem_newptr(sizeof(unsigned __int64) * cnt);
+  x->fz_vn = (unsigned __int64 *)sysmem_newptr(sizeof(unsigned __int64) * cnt);
+
+  if (!x->fz_peq || !x->fz_rpeq || !x->fz_vp || !x->fz_vn) {
+    object_error((t_object *)x, "errors:  Allocation error.");
+    strstr_fz_free(x);
+    return;
+  }
+
+  x->fz_blk_cnt = cnt;
+
+  // Set the bits on folded characters, then copy to the upper case letters
+  const unsigned char *fold = str_fold[x->icase ? 1 : 0];
+  for (t_dstr_int i = 0; i < len; i++) {
+    x->fz_peq[fold[ndl[i]] * cnt + i / 64] |= (unsigned __int64)1 << (i % 64);
+    x->fz_rpeq[fold[ndl[len - 1 - i]] * cnt + i / 64] |= (unsigned __int64)1 << (i % 64);
+  }
+
+  for (int c = 0; c < 256; c++) {
+    if (fold[c] == c) { continue; }
+    memcpy(x->fz_peq + c * cnt, x->fz_peq + fold[c] * cnt, sizeof(unsigned __int64) * cnt);
+    memcpy(x->fz_rpeq + c * cnt, x->fz_rpeq + fold[c] * cnt, sizeof(unsigned __int64) * cnt);
+  }
+}
+
+/****************************************************************
+*  Search for the approximate matches and store them for output
+*
+*  Each search starts after the end of the previous match.  The maximum
+*  distance is capped below the length of the searched string, so that a
+*  match is never empty.
+*/
+void strstr_fz_search(t_strstr *x, t_dstr hay, t_dstr_int len_n)
+{
+  const unsigned char *h = (const unsigned char *)DSTR_CSTR(hay);
+  t_dstr_int len_h = DSTR_LENGTH(hay);
+  t_dstr_int beg = 0;
+  t_dstr_int end;
+  t_dstr_int pos;
+  long dist;
+  long max = (x->errors < (long)len_n) ? x->errors : (long)len_n - 1;
+
+  x->o_pos = -1;
+  x->o_cnt = 0;
+  x->o_pos_cnt = 0;
+  if (!x->fz_peq) { return; }
+
+  while (beg < len_h) {
+    end = str_myers_end(x, h + beg, len_h - beg, len_n, max, &dist);
+    if (end == DSTR_LEN_ERR) { break; }
+    pos = beg + str_myers_start(x, h + beg, end, len_n, dist);
 
-  } else if (x->mode == 1) {
-    cp = strstr(DSTR_CSTR(x->i_dstr2), DSTR_CSTR(x->i_dstr1));
-    x->o_pos = cp ? (long)(cp - DSTR_CSTR(x->i_dstr2) + 1) : -1;
+    x->o_cnt++;
+    if (x->report != 2) {
+      strstr_add(x, (t_atom_long)pos + 1);
+      strstr_add(x, dist);
+    }
+    if (x->report == 0) { x->o_pos = (long)pos + 1; return; }
+
+    beg += end + 1;
   }
 }
 
+/****************************************************************
+*  Free the bitmasks of the approximate search
+*/
+void strstr_fz_free(t_strstr *x)
+{
+  if (x->fz_peq) { sysmem_freeptr(x->fz_peq); }
+  if (x->fz_rpeq) { sysmem_freeptr(x->fz_rpeq); }
+  if (x->fz_vp) { sysmem_freeptr(x->fz_vp); }
+  if (x->fz_vn) { sysmem_freeptr(x->fz_vn); }
+
+  x->fz_peq = NULL;
+  x->fz_rpeq = NULL;
+  x->fz_vp = NULL;
+  x->fz_vn = NULL;
+  x->fz_blk_cnt = 0;
+}
+
+/****************************************************************
+*  Build the suffix array of the string to search in
+*
+*  The suffixes are sorted by prefix doubling:  at each step, they are
+*  sorted by the pair of ranks of their first k characters and of the k
+*  following ones, with a counting sort, until all the ranks are distinct.
+*/
+void strstr_sa_build(t_strstr *x, t_dstr hay)
+{
+  const unsigned char *str = (const unsigned char *)DSTR_CSTR(hay);
+  t_dstr_int len = DSTR_LENGTH(hay);
+
+  x->sa_dirty = 0;
+  x->sa_len = len;
+
+  if (!x->sa_arr || (len > x->sa_max)) {
+    strstr_sa_free(x);
+    x->sa_max = (len > STR_POS_ALLOC) ? len : STR_POS_ALLOC;
+    x->sa_arr = (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * x->sa_max);
+    x->sa_tmp = (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * x->sa_max);
+  }
+
+  t_dstr_int cnt_max = (len > 256) ? len : 256;
+  t_dstr_int *rank = (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * x->sa_max);
+  t_dstr_int *next = (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * x->sa_max);
+  t_dstr_int *cnt = (t_dstr_int *)sysmem_newptr(sizeof(t_dstr_int) * cnt_max);
+
+  if (!x->sa_arr || !x->sa_tmp || !rank || !next || !cnt) {
+    object_error((t_object *)x, "indexed:  Allocation error.");
+    strstr_sa_free(x);
+    if (rank) { sysmem_freeptr(rank); }
+    if (next) { sysmem_freeptr(next); }
+    if (cnt) { sysmem_freeptr(cnt); }
+    return;
+  }
+
+  t_dstr_int *sa = x->sa_arr;
+  t_dstr_int *swap;
+  t_dstr_int cls = 256;
+  t_dstr_int i;
+  t_dstr_int p;
+
+  // Sort by the first character
+  memset(cnt, 0, sizeof(t_dstr_int) * 256);
+  for (i = 0; i < len; i++) { rank[i] = str[i]; cnt[str[i]]++; }
+  for (i = 1; i < 256; i++) { cnt[i] += cnt[i - 1]; }
+  for (i = len; i > 0; i--) { sa[--cnt[str[i - 1]]] = i - 1; }
+
+  for (t_dstr_int k = 1; k < len; k *= 2) {
+    // Order by the second half:  the suffixes without one first
+    p = 0;
+    for (i = len - k; i < len; i++) { next[p++] = i; }
+    for (i = 0; i < len; i++) { if (sa[i] >= k) { next[p++] = sa[i] - k; } }
+
+    // Stable counting sort by the first half
+    memset(cnt, 0, sizeof(t_dstr_int) * cls);
+    for (i = 0; i < len; i++) { cnt[rank[i]]++; }
+    for (i = 1; i < cls; i++) { cnt[i] += cnt[i - 1]; }
+    for (i = len; i > 0; i--) { sa[--cnt[rank[next[i - 1]]]] = next[i - 1]; }
+
+    // New ranks, from the pairs of ranks
+    next[sa[0]] = 0;
+    cls = 1;
+    for (i = 1; i < len; i++) {
+      t_dstr_int a = sa[i - 1];
+      t_dstr_int b = sa[i];
+      if ((rank[a] != rank[b]) || ((a + k < len) ? 1 + rank[a + k] : 0) != ((b + k < len) ? 1 + rank[b + k] : 0)) { cls++; }
+      next[b] = cls - 1;
+    }
+
+    swap = rank;
+    rank = next;
+    next = swap;
+    if (cls == len) { break; }
+  }
+
+  sysmem_freeptr(rank);
+  sysmem_freeptr(next);
+  sysmem_freeptr(cnt);
+}
+
+/****************************************************************
+*  Search with the suffix array, and store the matches for output
+*
+*  The matches in the range of the suffix array are selected from the start,
+*  or from the end for the reverse search, skipping the overlapping matches
+*  if necessary, as the scan would.  Only the list of all the positions and
+*  the count without overlap need all the matches sorted by position:  the
+*  first match is the smallest or largest position, and the nth match is
+*  found by sorting the next smallest or largest positions a block at a time.
+*/
+void strstr_sa_search(t_strstr *x, t_dstr hay, t_dstr ndl)
+{
+  const char *h = DSTR_CSTR(hay);
+  const char *n = DSTR_CSTR(ndl);
+  t_dstr_int len_h = x->sa_len;
+  t_dstr_int len_n = DSTR_LENGTH(ndl);
+  t_dstr_int lo = 0;
+  t_dstr_int hi = len_h;
+  t_dstr_int mid;
+  t_dstr_int end;
+
+  // First suffix not less than the searched string
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (str_sa_cmp(h, len_h, x->sa_arr[mid], n, len_n) < 0) { lo = mid + 1; } else { hi = mid; }
+  }
+
+  // First suffix greater, on the length of the searched string
+  end = len_h;
+  hi = lo;
+  while (hi < end) {
+    mid = hi + (end - hi) / 2;
+    if (str_sa_cmp(h, len_h, x->sa_arr[mid], n, len_n) == 0) { hi = mid + 1; } else { end = mid; }
+  }
+
+  x->o_pos = -1;
+
+  // Count of all the matches, without sorting
+  if ((x->report == 2) && x->overlap && !x->from) { x->o_cnt = (long)(hi - lo); return; }
+
+  // Matches within the part of the string selected by from and reverse
+  t_dstr_int off = ((t_dstr_int)x->from < len_h) ? (t_dstr_int)x->from : len_h;
+  t_dstr_int beg = (x->report || !x->reverse) ? off : 0;
+  t_dstr_int lim = (x->report || !x->reverse) ? len_h : len_h - off;
+  t_dstr_int step = x->overlap ? 1 : len_n;
+  t_dstr_int cnt = 0;
+  t_dstr_int first = x->reverse ? 0 : len_h;
+  t_dstr_int pos;
+
+  for (t_dstr_int i = lo; i < hi; i++) {
+    pos = x->sa_arr[i];
+    if ((pos >= beg) && (pos + len_n <= lim)) {
+      x->sa_tmp[cnt++] = pos;
+      if (x->reverse ? (pos > first) : (pos < first)) { first = pos; }
+    }
+  }
+
+  // Count of the matches with overlap, and first match:  no order needed
+  if ((x->report == 2) && x->overlap) { x->o_cnt = (long)cnt; return; }
+
+  if ((x->report == 0) && (x->nth == 1)) {
+    if (cnt) { x->o_cnt = 1; x->o_pos = (long)first + 1; }
+    return;
+  }
+
+  // Nth match:  sort the next smallest or largest positions by blocks
+  if (x->report == 0) {
+    t_dstr_int done = 0;
+    t_dstr_int blk;
+
+    while (done < cnt) {
+      blk = 2 * (t_dstr_int)(x->nth - x->o_cnt);
+      if (blk < 16) { blk = 16; }
+      if (blk > cnt - done) { blk = cnt - done; }
+      str_pos_select(x->sa_tmp + done, cnt - done, blk, x->reverse);
+      qsort(x->sa_tmp + done, blk, sizeof(t_dstr_int), x->reverse ? str_pos_rcmp : str_pos_cmp);
+
+      for (t_dstr_int i = done; i < done + blk; i++) {
+        pos = x->sa_tmp[i];
+        if (x->reverse) {
+          if (x->o_cnt && (pos + step > lim)) { continue; }
+          lim = pos;
+        } else {
+          if (x->o_cnt && (pos < beg)) { continue; }
+          beg = pos + step;
+        }
+        if (++x->o_cnt == x->nth) { x->o_pos = (long)pos + 1; return; }
+      }
+      done += blk;
+    }
+    return;
+  }
+
+  // List of all the matches, or count without overlap:  sorted by position
+  qsort(x->sa_tmp, cnt, sizeof(t_dstr_int), str_pos_cmp);
+
+  for (t_dstr_int i = 0; i < cnt; i++) {
+    pos = x->sa_tmp[i];
+    if (x->o_cnt && (pos < beg)) { continue; }
+    beg = pos + step;
+    x->o_cnt++;
+    if (x->report == 1) { strstr_add(x, (t_atom_long)pos + 1); }
+    if (x->o_cnt == 1) { x->o_pos = (long)pos + 1; }
+  }
+}
+
+/****************************************************************
+*  Free the suffix array
+*/
+void strstr_sa_free(t_strstr *x)
+{
+  if (x->sa_arr) { sysmem_freeptr(x->sa_arr); }
+  if (x->sa_tmp) { sysmem_freeptr(x->sa_tmp); }
+
+  x->sa_arr = NULL;
+  x->sa_tmp = NULL;
+  x->sa_max = 0;
+}
+
 /****************************************************************
 *  Output the string
 */
 void strstr_output(t_strstr *x)
 {
-  outlet_int(x->outl_int, x->o_pos);
+  switch (x->report) {
+  case 0:
+    if ((x->multi || x->errors) && x->o_pos_cnt) { outlet_list(x->outl_any, NULL, x->o_pos_cnt, x->o_pos_arr); }
+    else { outlet_int(x->outl_any, x->o_pos); }
+    break;
+  case 1:
+    if (x->o_pos_cnt) { outlet_list(x->outl_any, NULL, x->o_pos_cnt, x->o_pos_arr); }
+    else { outlet_int(x->outl_any, -1); }
+    break;
+  case 2: outlet_int(x->outl_any, x->o_cnt); break;
+  default: break;
+  }
+}
+
+/****************************************************************
+*  Search for a string in a string, choosing the algorithm from the length
+*
+*  @return The 0-based position of the first match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_search(t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n)
+{
+  if (len_n >= STR_HORSPOOL_MIN) { return str_horspool(hay, len_h, ndl, len_n, x->s_skip, x->icase); }
+  return str_memmem(hay, len_h, ndl, len_n, x->icase);
+}
+
+/****************************************************************
+*  Search backwards for a string in a string, choosing the algorithm from the length
+*
+*  @return The 0-based position of the last match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_rsearch(t_strstr *x, const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n)
+{
+  if (len_n >= STR_HORSPOOL_MIN) { return str_rhorspool(hay, len_h, ndl, len_n, x->s_rskip, x->icase); }
+  return str_rmemmem(hay, len_h, ndl, len_n, x->icase);
+}
+
+/****************************************************************
+*  Search for a string in a string, filtering on the first and last characters
+*
+*  With SSE2, 16 candidate positions are tested at a time:  the bitmask of
+*  the positions where both the first and last characters match is computed,
+*  and only these candidates are compared in full.
+*  For case insensitive searches, the characters are folded in the registers.
+*
+*  @return The 0-based position of the first match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_memmem(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, long icase)
+{
+  if (len_n == 0) { return 0; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  if ((len_n == 1) && !icase) {
+    const char *cp = (const char *)memchr(hay, ndl[0], len_h);
+    return cp ? (t_dstr_int)(cp - hay) : DSTR_LEN_ERR;
+  }
+
+  const unsigned char *h = (const unsigned char *)hay;
+  const unsigned char *fold = str_fold[icase];
+  unsigned char c_first = fold[(unsigned char)ndl[0]];
+  t_dstr_int last = len_n - 1;
+  unsigned char c_last = fold[(unsigned char)ndl[last]];
+  t_dstr_int end = len_h - len_n;   // last candidate position
+  t_dstr_int i = 0;
+
+#ifdef STR_SSE2
+  __m128i first_16 = _mm_set1_epi8((char)c_first);
+  __m128i last_16 = _mm_set1_epi8((char)c_last);
+  __m128i hay_first;
+  __m128i hay_last;
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; i + 15 <= end; i += 16) {
+    hay_first = _mm_loadu_si128((const __m128i *)(hay + i));
+    hay_last = _mm_loadu_si128((const __m128i *)(hay + i + last));
+    if (icase) {
+      hay_first = str_fold_sse2(hay_first, icase);
+      hay_last = str_fold_sse2(hay_last, icase);
+    }
+    mask = (unsigned long)_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(first_16, hay_first), _mm_cmpeq_epi8(last_16, hay_last)));
+
+    while (mask) {
+      _BitScanForward(&bit, mask);
+      if (str_equal(hay + i + bit, ndl, len_n, icase)) { return i + bit; }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  // Remaining candidates
+  for (; i <= end; i++) {
+    if ((fold[h[i]] == c_first) && (fold[h[i + last]] == c_last) && str_equal(hay + i, ndl, len_n, icase)) { return i; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Search backwards for a string in a string, with the same filter as str_memmem()
+*
+*  The candidate positions are tested from the end, 16 at a time with SSE2,
+*  taking the highest bit of each mask first.
+*
+*  @return The 0-based position of the last match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_rmemmem(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, long icase)
+{
+  if (len_n == 0) { return len_h; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  const unsigned char *h = (const unsigned char *)hay;
+  const unsigned char *fold = str_fold[icase];
+  unsigned char c_first = fold[(unsigned char)ndl[0]];
+  t_dstr_int last = len_n - 1;
+  unsigned char c_last = fold[(unsigned char)ndl[last]];
+  t_dstr_int cnt = len_h - len_n + 1;   // candidate positions below cnt
+  t_dstr_int i;
+
+#ifdef STR_SSE2
+  __m128i first_16 = _mm_set1_epi8((char)c_first);
+  __m128i last_16 = _mm_set1_epi8((char)c_last);
+  __m128i hay_first;
+  __m128i hay_last;
+  unsigned long mask;
+  unsigned long bit;
+
+  for (; cnt >= 16; cnt -= 16) {
+    i = cnt - 16;
+    hay_first = _mm_loadu_si128((const __m128i *)(hay + i));
+    hay_last = _mm_loadu_si128((const __m128i *)(hay + i + last));
+    if (icase) {
+      hay_first = str_fold_sse2(hay_first, icase);
+      hay_last = str_fold_sse2(hay_last, icase);
+    }
+    mask = (unsigned long)_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(first_16, hay_first), _mm_cmpeq_epi8(last_16, hay_last)));
+
+    while (mask) {
+      _BitScanReverse(&bit, mask);
+      if (str_equal(hay + i + bit, ndl, len_n, icase)) { return i + bit; }
+      mask &= ~(1UL << bit);
+    }
+  }
+#endif
+
+  // Remaining candidates
+  for (; cnt > 0; cnt--) {
+    i = cnt - 1;
+    if ((fold[h[i]] == c_first) && (fold[h[i + last]] == c_last) && str_equal(hay + i, ndl, len_n, icase)) { return i; }
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Compare two strings of the same length, with optional case folding
+*
+*  With icase 2, a UTF-8 continuation byte is folded only if it follows
+*  0xC3, in which case both strings have 0xC3 at the previous position.
+*
+*  @return 1 if the strings are equal, 0 otherwise.
+*/
+short str_equal(const char *str1, const char *str2, t_dstr_int len, long icase)
+{
+  if (!icase) { return !memcmp(str1, str2, len); }
+
+  const unsigned char *s1 = (const unsigned char *)str1;
+  const unsigned char *s2 = (const unsigned char *)str2;
+  unsigned char lc;
+
+  for (t_dstr_int i = 0; i < len; i++) {
+    if (s1[i] == s2[i]) { continue; }
+    if ((s1[i] ^ s2[i]) != 0x20) { return 0; }
+
+    lc = s1[i] | 0x20;
+    if ((lc >= 'a') && (lc <= 'z')) { continue; }
+    if ((icase == 2) && (i > 0) && (s2[i - 1] == 0xC3) && (lc >= 0xA0) && (lc <= 0xBE) && (lc != 0xB7)) { continue; }
+    return 0;
+  }
+
+  return 1;
+}
+
+/****************************************************************
+*  Initialize the global folding tables
+*/
+void str_fold_init(void)
+{
+  for (int c = 0; c < 256; c++) {
+    str_fold[0][c] = (unsigned char)c;
+    str_fold[1][c] = ((c >= 'A') && (c <= 'Z')) ? (unsigned char)(c + 0x20) : (unsigned char)c;
+    str_fold[2][c] = ((c >= 0x80) && (c <= 0x9E) && (c != 0x97)) ? (unsigned char)(c + 0x20) : str_fold[1][c];
+  }
+}
+
+#ifdef STR_SSE2
+/****************************************************************
+*  Fold 16 characters as in the folding tables
+*/
+__m128i str_fold_sse2(__m128i v, long icase)
+{
+  // ASCII upper case:  'A' to 'Z', compared as signed chars
+  __m128i is_upper = _mm_and_si128(
+    _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+
+  // Latin-1 upper case continuation bytes:  0x80 to 0x9E, negative as signed chars, except 0x97
+  if (icase == 2) {
+    is_upper = _mm_or_si128(is_upper, _mm_andnot_si128(
+      _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0x97)), _mm_cmplt_epi8(v, _mm_set1_epi8((char)0x9F))));
+  }
+
+  return _mm_or_si128(v, _mm_and_si128(is_upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+/****************************************************************
+*  Horspool search of a string in a string, using explicit lengths
+*
+*  @param skip The skip table of the searched string, indexed by folded characters.
+*
+*  @return The 0-based position of the first match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_horspool(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, const t_dstr_int *skip, long icase)
+{
+  // An empty string is found at the start, as with strstr()
+  if (len_n == 0) { return 0; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  const unsigned char *fold = str_fold[icase];
+  t_dstr_int last = len_n - 1;
+  unsigned char c_last = fold[(unsigned char)ndl[last]];
+  t_dstr_int end = len_h - len_n;
+  t_dstr_int i = 0;
+  unsigned char c;
+
+  while (i <= end) {
+    c = fold[(unsigned char)hay[i + last]];
+    if ((c == c_last) && str_equal(hay + i, ndl, len_n, icase)) { return i; }
+    i += skip[c];
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Reverse Horspool search of a string in a string, using explicit lengths
+*
+*  The window moves towards the start, on the character under its first position.
+*
+*  @param skip The reverse skip table of the searched string, indexed by folded characters.
+*
+*  @return The 0-based position of the last match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_rhorspool(const char *hay, t_dstr_int len_h, const char *ndl, t_dstr_int len_n, const t_dstr_int *skip, long icase)
+{
+  if (len_n == 0) { return len_h; }
+  if (len_n > len_h) { return DSTR_LEN_ERR; }
+
+  const unsigned char *fold = str_fold[icase];
+  unsigned char c_first = fold[(unsigned char)ndl[0]];
+  t_dstr_int i = len_h - len_n;
+  unsigned char c;
+
+  while (1) {
+    c = fold[(unsigned char)hay[i]];
+    if ((c == c_first) && str_equal(hay + i, ndl, len_n, icase)) { return i; }
+    if (i < skip[c]) { break; }
+    i -= skip[c];
+  }
+
+  return DSTR_LEN_ERR;
+}
+
+/****************************************************************
+*  Compare a suffix to a string, on the length of the string
+*
+*  @return A negative, zero or positive value, as memcmp().
+*/
+int str_sa_cmp(const char *hay, t_dstr_int len_h, t_dstr_int pos, const char *ndl, t_dstr_int len_n)
+{
+  t_dstr_int len = len_h - pos;
+  int cmp = memcmp(hay + pos, ndl, (len < len_n) ? len : len_n);
+
+  if (cmp) { return cmp; }
+  return (len < len_n) ? -1 : 0;
+}
+
+/****************************************************************
+*  Comparison of positions for qsort:  by increasing position
+*/
+int str_pos_cmp(const void *pos1, const void *pos2)
+{
+  t_dstr_int p1 = *(const t_dstr_int *)pos1;
+  t_dstr_int p2 = *(const t_dstr_int *)pos2;
+
+  return (p1 > p2) - (p1 < p2);
+}
+
+/****************************************************************
+*  Comparison of positions for qsort:  by decreasing position
+*/
+int str_pos_rcmp(const void *pos1, const void *pos2)
+{
+  t_dstr_int p1 = *(const t_dstr_int *)pos1;
+  t_dstr_int p2 = *(const t_dstr_int *)pos2;
+
+  return (p1 < p2) - (p1 > p2);
+}
+
+/****************************************************************
+*  Partial selection of positions
+*
+*  Reorders the array so that its first k items are the k smallest
+*  positions, or the k largest with rev, in any order.  The array is
+*  partitioned around a middle pivot, keeping only the side with the kth
+*  item, as in a quicksort that would stop there.
+*/
+void str_pos_select(t_dstr_int *arr, t_dstr_int cnt, t_dstr_int k, long rev)
+{
+  long lo = 0;
+  long hi = (long)cnt - 1;
+  long kth = (long)k - 1;
+  long i, j;
+  t_dstr_int piv, tmp;
+
+  if ((k == 0) || (k >= cnt)) { return; }
+
+  while (lo < hi) {
+    piv = arr[lo + (hi - lo) / 2];
+    i = lo;
+    j = hi;
+
+    while (i <= j) {
+      if (rev) {
+        while (arr[i] > piv) { i++; }
+        while (arr[j] < piv) { j--; }
+      } else {
+        while (arr[i] < piv) { i++; }
+        while (arr[j] > piv) { j--; }
+      }
+      if (i <= j) { tmp = arr[i]; arr[i] = arr[j]; arr[j] = tmp; i++; j--; }
+    }
+
+    if (kth <= j) { hi = j; } else if (kth >= i) { lo = i; } else { break; }
+  }
+}
+
+/****************************************************************
+*  Find the end of the first approximate match, with the algorithm of Myers
+*
+*  The distance of the searched string to the best substring ending at each
+*  position is updated one column at a time.  The first position within
+*  the maximum distance is extended while the distance decreases.
+*
+*  @param max The maximum distance of a match.
+*  @param dist Set to the distance of the match.
+*
+*  @return The 0-based position of the last character of the match, or DSTR_LEN_ERR.
+*/
+t_dstr_int str_myers_end(t_strstr *x, const unsigned char *hay, t_dstr_int len_h, t_dstr_int len_n, long max, long *dist)
+{
+  long cnt = x->fz_blk_cnt;
+  unsigned __int64 last = (unsigned __int64)1 << ((len_n - 1) % 64);
+  t_dstr_int end = DSTR_LEN_ERR;
+  long score = (long)len_n;
+
+  // Any substring can start the match:  the top row is 0
+  for (long b = 0; b < cnt; b++) { x->fz_vp[b] = ~(unsigned __int64)0; x->fz_vn[b] = 0; }
+
+  for (t_dstr_int j = 0; j < len_h; j++) {
+    score += str_myers_advance(x->fz_vp, x->fz_vn, x->fz_peq + hay[j] * cnt, cnt, last, 0);
+
+    if ((score <= max) && ((end == DSTR_LEN_ERR) || (score < *dist))) { end = j; *dist = score; }
+    else if (end != DSTR_LEN_ERR) { break; }
+  }
+
+  return end;
+}
+
+/****************************************************************
+*  Find the start of an approximate match, from its end and distance
+*
+*  The reversed string is compared to the substrings ending at the end of
+*  the match, from the shortest, with the top row counting the characters.
+*
+*  @return The 0-based position of the first character of the match.
+*/
+t_dstr_int str_myers_start(t_strstr *x, const unsigned char *hay, t_dstr_int end, t_dstr_int len_n, long dist)
+{
+  long cnt = x->fz_blk_cnt;
+  unsigned __int64 last = (unsigned __int64)1 << ((len_n - 1) % 64);
+  long score = (long)len_n;
+  t_dstr_int c = 0;
+
+  for (long b = 0; b < cnt; b++) { x->fz_vp[b] = ~(unsigned __int64)0; x->fz_vn[b] = 0; }
+
+  while ((score != dist) && (c <= end)) {
+    score += str_myers_advance(x->fz_vp, x->fz_vn, x->fz_rpeq + hay[end - c] * cnt, cnt, last, 1);
+    c++;
+  }
+
+  return end + 1 - c;
+}
+
+/****************************************************************
+*  Advance the bit-parallel edit distance computation by one column
+*
+*  @param vp, vn The positive and negative vertical deltas of each block.
+*  @param eq The match bitmasks of the character, for each block.
+*  @param last The bit of the last row in the last block.
+*  @param hin The horizontal delta entering the top row:  -1, 0 or 1.
+*
+*  @return The horizontal delta leaving the last row.
+*/
+long str_myers_advance(unsigned __int64 *vp, unsigned __int64 *vn, const unsigned __int64 *eq, long blk_cnt, unsigned __int64 last, long hin)
+{
+  unsigned __int64 high = (unsigned __int64)1 << 63;
+  unsigned __int64 pv, mv, e, xv, xh, ph, mh;
+  long hout;
+
+  for (long b = 0; b < blk_cnt; b++) {
+    if (b == blk_cnt - 1) { high = last; }
+    pv = vp[b];
+    mv = vn[b];
+    e = eq[b];
+
+    xv = e | mv;
+    if (hin < 0) { e |= 1; }
+    xh = (((e & pv) + pv) ^ pv) | e;
+    ph = mv | ~(xh | pv);
+    mh = pv & xh;
+
+    hout = (ph & high) ? 1 : ((mh & high) ? -1 : 0);
+
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0) { mh |= 1; }
+    else if (hin > 0) { ph |= 1; }
+
+    vp[b] = mh | ~(xv | ph);
+    vn[b] = ph & xv;
+    hin = hout;
+  }
+
+  return hin;
 }
 
 /****************************************************************
@@ -369,6 +1654,8 @@ t_max_err str_mode_set(t_strstr *x, void *attr, long argc, t_atom *argv)
 {
   if (argc && argv) { x->mode = (long)atom_getlong(argv); } else { x->mode = 0; }
 
+  x->s_dirty = 1;
+  x->sa_dirty = 1;
   strstr_action(x);
   return MAX_ERR_NONE;
 }
@@ -386,3 +1673,105 @@ t_max_err str_fprecision_set(t_strstr *x, void *attr, long argc, t_atom *argv)
 
   return MAX_ERR_NONE;
 }
+
+/****************************************************************
+*  Custom setter for the report attribute
+*/
+t_max_err str_report_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->report = (long)atom_getlong(argv); } else { x->report = 0; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the overlap attribute
+*/
+t_max_err str_overlap_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->overlap = (long)atom_getlong(argv); } else { x->overlap = 0; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the multi attribute
+*/
+t_max_err str_multi_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->multi = (long)atom_getlong(argv); } else { x->multi = 0; }
+
+  x->s_dirty = 1;
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the ignore case attribute
+*/
+t_max_err str_icase_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->icase = (long)atom_getlong(argv); } else { x->icase = 0; }
+
+  x->s_dirty = 1;
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the errors attribute
+*/
+t_max_err str_errors_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->errors = (long)atom_getlong(argv); } else { x->errors = 0; }
+
+  x->s_dirty = 1;
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the start offset attribute
+*/
+t_max_err str_from_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->from = (long)atom_getlong(argv); } else { x->from = 0; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the reverse attribute
+*/
+t_max_err str_reverse_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->reverse = (long)atom_getlong(argv); } else { x->reverse = 0; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the nth attribute
+*/
+t_max_err str_nth_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->nth = (long)atom_getlong(argv); } else { x->nth = 1; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the indexed attribute
+*/
+t_max_err str_indexed_set(t_strstr *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->indexed = (long)atom_getlong(argv); } else { x->indexed = 0; }
+
+  strstr_action(x);
+  return MAX_ERR_NONE;
+}
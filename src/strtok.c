@@ -10,8 +10,23 @@
 *    - dynamic strings,
 *    - attributes.
 *
+*  Streaming mode (stream 1):  the string is received in chunks,
+*  a partial token at the end of a chunk is carried over to the next one,
+*  and the flush message outputs the remainder.
+*
+*  Typed mode (typed 1):  tokens that parse as integers or floats are output
+*  as int or float atoms instead of symbols.
+*
+*  Index mode (index start count):  only the tokens from the 1-based start
+*  position are output, and the scan stops as soon as they are found.
+*  The nth message does the same for a single output.
+*
+*  Counting mode (counting 1):  tokens are counted in a hash table instead
+*  of being output, the dump message outputs the counts sorted by frequency,
+*  and the clear message resets them.  Only new text in the string buffer is
+*  counted:  a new separator or an attribute change does not count again.
+*
 *  @todo:  - strtok_action: test for NULL strings
-*          - dynamic array of atoms, or test for length
 *   
 */
 
@@ -25,6 +40,24 @@
 /****************************************************************
 *  Preprocessor
 */
+#define STR_TOK_ALLOC 256
+#define STR_TOK_MAX   32767   // outlet_anything() takes a short count
+#define STR_CNT_ALLOC 64      // initial size of the hash table, a power of 2
+
+/****************************************************************
+*  Hash table entry for token counts
+*
+*  The token is stored in the pool dstring at position pos,
+*  NULL terminated so that it can be interned directly.
+*/
+typedef struct _str_count
+{
+  unsigned long hash;
+  t_dstr_int    pos;
+  t_dstr_int    len;
+  long          count;
+
+} t_str_count;
 
 /****************************************************************
 *  Max object structure
@@ -39,11 +72,22 @@ typedef struct _strtok
   
   t_dstr    i_dstr1;
   t_dstr    i_dstr2;
-  t_atom    o_tok_arr[256];
+  t_dstr    i_carry;
+  t_atom   *o_tok_arr;
+  short     o_tok_max;
   short     o_tok_cnt;
-  t_symbol *o_tok_first;
+
+  t_str_count *cnt_table;
+  long         cnt_max;
+  long         cnt_num;
+  t_dstr       cnt_pool;
+  char         cnt_input;   // the string buffer just received new text
 
   long  mode;
+  long  stream;
+  long  typed;
+  long  index[2];
+  long  counting;
   long  fprecision;
   char  format[6];
 
@@ -68,15 +112,31 @@ void  strtok_list     (t_strtok *x, t_symbol *sym, long argc, t_atom *argv);
 void  strtok_anything (t_strtok *x, t_symbol *sym, long argc, t_atom *argv);
 void  strtok_set      (t_strtok *x, t_symbol *sym, long argc, t_atom *argv);
 void  strtok_post     (t_strtok *x);
+void  strtok_flush    (t_strtok *x);
+void  strtok_nth      (t_strtok *x, t_symbol *sym, long argc, t_atom *argv);
+void  strtok_dump     (t_strtok *x);
+void  strtok_clear    (t_strtok *x);
 
+void  strtok_input    (t_strtok *x, t_dstr dstr, char output);
 void  strtok_action   (t_strtok *x);
+void  strtok_stream   (t_strtok *x);
+void  strtok_index    (t_strtok *x, long start, long count);
 void  strtok_output   (t_strtok *x);
+short strtok_add      (t_strtok *x, char *token);
+short strtok_count    (t_strtok *x, char *token);
 
+short     str_atom_from_token(t_atom *atom, char *token);
+void      str_sep_table      (char *is_sep, t_dstr sep);
+unsigned long str_hash       (const char *str, t_dstr_int len);
+int       str_count_cmp      (const void *a, const void *b);
 t_dstr    str_proxy_to_dstr  (t_strtok *x);
 t_dstr    str_cat_atom       (t_strtok *x, t_dstr dstr, t_atom *atom);
 t_dstr    str_cat_args       (t_strtok *x, t_dstr dstr, long argc, t_atom *argv);
 t_max_err str_mode_set       (t_strtok *x, void *attr, long argc, t_atom *argv);
 t_max_err str_fprecision_set (t_strtok *x, void *attr, long argc, t_atom *argv);
+t_max_err str_stream_set     (t_strtok *x, void *attr, long argc, t_atom *argv);
+t_max_err str_typed_set      (t_strtok *x, void *attr, long argc, t_atom *argv);
+t_max_err str_index_set      (t_strtok *x, void *attr, long argc, t_atom *argv);
 
 
 /****************************************************************
@@ -101,6 +161,10 @@ void ext_main(void *r)
   class_addmethod(c, (method)strtok_anything, "anything",  A_GIMME, 0);
   class_addmethod(c, (method)strtok_set,      "set",       A_GIMME, 0);
   class_addmethod(c, (method)strtok_post,     "post",               0);
+  class_addmethod(c, (method)strtok_flush,    "flush",              0);
+  class_addmethod(c, (method)strtok_nth,      "nth",       A_GIMME, 0);
+  class_addmethod(c, (method)strtok_dump,     "dump",               0);
+  class_addmethod(c, (method)strtok_clear,    "clear",              0);
   class_addmethod(c, (method)stdinletinfo,    "inletinfo", A_CANT,  0);
 
   CLASS_ATTR_LONG(c, "mode", 0, t_strtok, mode);
@@ -119,6 +183,36 @@ void ext_main(void *r)
   CLASS_ATTR_SELFSAVE(c, "fprecision", 0);
   CLASS_ATTR_ACCESSORS(c, "fprecision", NULL, str_fprecision_set);
 
+  CLASS_ATTR_LONG(c, "stream", 0, t_strtok, stream);
+  CLASS_ATTR_ORDER(c, "stream", 0, "3");
+  CLASS_ATTR_LABEL(c, "stream", 0, "streaming");
+  CLASS_ATTR_FILTER_CLIP(c, "stream", 0, 1);
+  CLASS_ATTR_SAVE(c, "stream", 0);
+  CLASS_ATTR_SELFSAVE(c, "stream", 0);
+  CLASS_ATTR_ACCESSORS(c, "stream", NULL, str_stream_set);
+
+  CLASS_ATTR_LONG(c, "typed", 0, t_strtok, typed);
+  CLASS_ATTR_ORDER(c, "typed", 0, "4");
+  CLASS_ATTR_LABEL(c, "typed", 0, "typed numeric tokens");
+  CLASS_ATTR_FILTER_CLIP(c, "typed", 0, 1);
+  CLASS_ATTR_SAVE(c, "typed", 0);
+  CLASS_ATTR_SELFSAVE(c, "typed", 0);
+  CLASS_ATTR_ACCESSORS(c, "typed", NULL, str_typed_set);
+
+  CLASS_ATTR_LONG_ARRAY(c, "index", 0, t_strtok, index, 2);
+  CLASS_ATTR_ORDER(c, "index", 0, "5");
+  CLASS_ATTR_LABEL(c, "index", 0, "token index and count");
+  CLASS_ATTR_SAVE(c, "index", 0);
+  CLASS_ATTR_SELFSAVE(c, "index", 0);
+  CLASS_ATTR_ACCESSORS(c, "index", NULL, str_index_set);
+
+  CLASS_ATTR_LONG(c, "counting", 0, t_strtok, counting);
+  CLASS_ATTR_ORDER(c, "counting", 0, "6");
+  CLASS_ATTR_LABEL(c, "counting", 0, "count tokens");
+  CLASS_ATTR_FILTER_CLIP(c, "counting", 0, 1);
+  CLASS_ATTR_SAVE(c, "counting", 0);
+  CLASS_ATTR_SELFSAVE(c, "counting", 0);
+
   class_register(CLASS_BOX, c);
   strtok_class = c;
 }
@@ -151,8 +245,21 @@ void *strtok_new(t_symbol *sym, long argc, t_atom *argv)
     x->i_dstr2 = str_cat_atom(x, x->i_dstr2, argv);
   }
 
+  // Set the carry buffer for streaming and the token array
+  x->i_carry = dstr_new();
+  x->o_tok_max = STR_TOK_ALLOC;
+  x->o_tok_arr = (t_atom *)sysmem_newptr(sizeof(t_atom) * x->o_tok_max);
+
+  // Set the hash table for counting
+  x->cnt_max = STR_CNT_ALLOC;
+  x->cnt_num = 0;
+  x->cnt_table = (t_str_count *)sysmem_newptrclear(sizeof(t_str_count) * x->cnt_max);
+  x->cnt_pool = dstr_new();
+  x->cnt_input = 0;
+
   // Test the string buffers
-  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2) || DSTR_IS_NULL(x->i_carry) || !x->o_tok_arr
+    || !x->cnt_table || DSTR_IS_NULL(x->cnt_pool)) {
     object_error((t_object *)x, "Allocation error.");
     strtok_free(x);
     return NULL;
@@ -174,7 +281,11 @@ void *strtok_new(t_symbol *sym, long argc, t_atom *argv)
 
   // Set the remaining variables
   x->o_tok_cnt = 0;
-  x->o_tok_first = gensym("");
+  x->stream = 0;
+  x->typed = 0;
+  x->index[0] = 0;
+  x->index[1] = 1;
+  x->counting = 0;
 
   // Process the attributes
   attr_args_process(x, (short)argc, argv);
@@ -189,6 +300,10 @@ void strtok_free(t_strtok *x)
 {
   dstr_free(&x->i_dstr1);
   dstr_free(&x->i_dstr2);
+  dstr_free(&x->i_carry);
+  if (x->o_tok_arr) { sysmem_freeptr(x->o_tok_arr); }
+  if (x->cnt_table) { sysmem_freeptr(x->cnt_table); }
+  dstr_free(&x->cnt_pool);
   freeobject((t_object *)x->inl_proxy);
 }
 
@@ -233,8 +348,7 @@ void strtok_int(t_strtok *x, long n)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_int(dstr, n);
-  strtok_action(x);
-  if (dstr == x->i_dstr1) { strtok_output(x); }
+  strtok_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -245,8 +359,7 @@ void strtok_float(t_strtok *x, double f)
   t_dstr dstr = str_proxy_to_dstr(x);
 
   dstr_cpy_printf(dstr, x->format, f);
-  strtok_action(x);
-  if (dstr == x->i_dstr1) { strtok_output(x); }
+  strtok_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -258,8 +371,7 @@ void strtok_list(t_strtok *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strtok_action(x);
-  if (dstr == x->i_dstr1) { strtok_output(x); }
+  strtok_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -271,8 +383,7 @@ void strtok_anything(t_strtok *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_cpy_cstr(dstr, sym->s_name);
   str_cat_args(x, dstr, argc, argv);
-  strtok_action(x);
-  if (dstr == x->i_dstr1) { strtok_output(x); }
+  strtok_input(x, dstr, 1);
 }
 
 /****************************************************************
@@ -284,7 +395,7 @@ void strtok_set(t_strtok *x, t_symbol *sym, long argc, t_atom *argv)
 
   dstr_empty(dstr);
   str_cat_args(x, dstr, argc, argv);
-  strtok_action(x);
+  strtok_input(x, dstr, 0);
 }
 
 /****************************************************************
@@ -294,11 +405,116 @@ void strtok_post(t_strtok *x)
 {
   object_post((t_object *)x, "Mode:  %i", x->mode);
   object_post((t_object *)x, "Float precision:  %i", x->fprecision);
-  object_post((t_object *)x, "Token count:  %i", x->o_tok_cnt);
-  object_post((t_object *)x, "Alloc:  Left: %i - Right: %i",
-    DSTR_ALLOC(x->i_dstr1), DSTR_ALLOC(x->i_dstr2));
+  object_post((t_object *)x, "Stream:  %i", x->stream);
+  object_post((t_object *)x, "Typed:  %i", x->typed);
+  object_post((t_object *)x, "Index:  %i - Count: %i", x->index[0], x->index[1]);
+  object_post((t_object *)x, "Counting:  %i - Tokens: %i - Table: %i - Pool: %i",
+    x->counting, x->cnt_num, x->cnt_max, DSTR_ALLOC(x->cnt_pool));
+  object_post((t_object *)x, "Token count:  %i - Alloc: %i", x->o_tok_cnt, x->o_tok_max);
+  object_post((t_object *)x, "Alloc:  Left: %i - Right: %i - Carry: %i",
+    DSTR_ALLOC(x->i_dstr1), DSTR_ALLOC(x->i_dstr2), DSTR_ALLOC(x->i_carry));
   object_post((t_object *)x, "Left: %s", DSTR_CSTR(x->i_dstr1));
   object_post((t_object *)x, "Right: %s", DSTR_CSTR(x->i_dstr2));
+  object_post((t_object *)x, "Carry: %s", DSTR_CSTR(x->i_carry));
+}
+
+/****************************************************************
+*  Output the carried over partial token and empty the carry buffer
+*/
+void strtok_flush(t_strtok *x)
+{
+  x->o_tok_cnt = 0;
+  if (DSTR_IS_NULL(x->i_carry)) { return; }
+
+  if (DSTR_LENGTH(x->i_carry)) {
+    x->cnt_input = 1;
+    strtok_add(x, DSTR_CSTR(x->i_carry));
+    x->cnt_input = 0;
+    dstr_empty(x->i_carry);
+    strtok_output(x);
+  }
+}
+
+/****************************************************************
+*  Output a range of tokens from the string, regardless of the index attribute
+*
+*  nth start [count]:  start is 1-based, count defaults to 1.
+*/
+void strtok_nth(t_strtok *x, t_symbol *sym, long argc, t_atom *argv)
+{
+  if ((argc < 1) || (atom_getlong(argv) < 1)) {
+    object_error((t_object *)x, "nth:  Token index:  Positive int expected");
+    return;
+  }
+
+  strtok_index(x, (long)atom_getlong(argv), (argc >= 2) ? (long)atom_getlong(argv + 1) : 1);
+  strtok_output(x);
+}
+
+/****************************************************************
+*  Output the token counts, sorted by decreasing frequency
+*/
+void strtok_dump(t_strtok *x)
+{
+  if (x->cnt_num == 0) { return; }
+
+  t_str_count *sorted = (t_str_count *)sysmem_newptr(sizeof(t_str_count) * x->cnt_num);
+  if (!sorted) {
+    object_error((t_object *)x, "dump:  Allocation error.");
+    return;
+  }
+
+  long num = 0;
+  for (long i = 0; i < x->cnt_max; i++) {
+    if (x->cnt_table[i].count) { sorted[num++] = x->cnt_table[i]; }
+  }
+  qsort(sorted, num, sizeof(t_str_count), str_count_cmp);
+
+  t_atom count;
+  for (long i = 0; i < num; i++) {
+    atom_setlong(&count, sorted[i].count);
+    outlet_anything(x->outl_any, gensym(DSTR_CSTR(x->cnt_pool) + sorted[i].pos), 1, &count);
+  }
+
+  sysmem_freeptr(sorted);
+}
+
+/****************************************************************
+*  Reset the token counts
+*/
+void strtok_clear(t_strtok *x)
+{
+  if (x->cnt_table) { memset(x->cnt_table, 0, sizeof(t_str_count) * x->cnt_max); }
+  x->cnt_num = 0;
+
+  // A pool lost on an allocation error is allocated again
+  if (DSTR_IS_NULL(x->cnt_pool)) { dstr_free(&x->cnt_pool); x->cnt_pool = dstr_new(); }
+  dstr_empty(x->cnt_pool);
+}
+
+/****************************************************************
+*  Dispatch a new input, depending on the streaming mode
+*
+*  @param dstr The string buffer that was just modified.
+*  @param output Whether the input should trigger an output.
+*/
+void strtok_input(t_strtok *x, t_dstr dstr, char output)
+{
+  char is_str = (dstr == ((x->mode == 0) ? x->i_dstr1 : x->i_dstr2));
+
+  // In streaming mode, each chunk received by the string buffer is tokenized
+  if (x->stream && is_str) {
+    x->cnt_input = 1;
+    strtok_stream(x);
+    x->cnt_input = 0;
+    if (output) { strtok_output(x); }
+    return;
+  }
+
+  x->cnt_input = is_str;
+  strtok_action(x);
+  x->cnt_input = 0;
+  if (output && (dstr == x->i_dstr1)) { strtok_output(x); }
 }
 
 /****************************************************************
@@ -306,6 +522,12 @@ void strtok_post(t_strtok *x)
 */
 void strtok_action(t_strtok *x)
 {
+  // In streaming mode the string buffer is only processed chunk by chunk
+  if (x->stream) { return; }
+
+  // In index mode only the requested tokens are scanned for
+  if (x->index[0] > 0) { strtok_index(x, x->index[0], x->index[1]); return; }
+
   t_dstr temp = dstr_new_dstr((x->mode == 0) ? x->i_dstr1 : x->i_dstr2);
 
   // Test that the t_dstr strings are not NULL
@@ -315,38 +537,320 @@ void strtok_action(t_strtok *x)
     return;
   }
 
-  short cnt = 0;
   char *token = NULL;
   char *next_token = NULL;
   char *sep = (x->mode == 0) ? DSTR_CSTR(x->i_dstr2) : DSTR_CSTR(x->i_dstr1);
 
+  x->o_tok_cnt = 0;
   token = strtok_s(DSTR_CSTR(temp), sep, &next_token);
 
-  if (token) {
-    cnt++;
-    x->o_tok_first = gensym(token);
+  while (token && strtok_add(x, token)) {
     token = strtok_s(NULL, sep, &next_token);
-
-    while (token) {
-      atom_setsym(x->o_tok_arr + cnt++ - 1, gensym(token));
-      token = strtok_s(NULL, sep, &next_token);
-    }
-    x->o_tok_cnt = cnt;
-  } 
+  }
 
   dstr_free(&temp);
 }
 
+/****************************************************************
+*  Tokenize a chunk of a stream
+*
+*  The chunk is appended to the carry buffer, the tokens closed by a
+*  separator are stored for output, and the trailing partial token
+*  is kept in the carry buffer until the next chunk or a flush.
+*/
+void strtok_stream(t_strtok *x)
+{
+  t_dstr chunk = (x->mode == 0) ? x->i_dstr1 : x->i_dstr2;
+  t_dstr sep = (x->mode == 0) ? x->i_dstr2 : x->i_dstr1;
+
+  dstr_cat_dstr(x->i_carry, chunk);
+  x->o_tok_cnt = 0;
+
+  // Test that the t_dstr strings are not NULL
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2) || DSTR_IS_NULL(x->i_carry)) {
+    object_error((t_object *)x, "Allocation error. Reset the external.");
+    return;
+  }
+
+  char is_sep[256];
+  str_sep_table(is_sep, sep);
+
+  char *beg = DSTR_CSTR(x->i_carry);
+  char *end = beg + DSTR_LENGTH(x->i_carry);
+  char *pc = beg;
+  char *rest = beg;
+  char *token;
+
+  while (1) {
+
+    // Skip the separators
+    while ((pc < end) && is_sep[(unsigned char)*pc]) { pc++; }
+    rest = token = pc;
+    if (pc == end) { break; }
+
+    // Find the end of the token, and carry it over if it is not closed
+    while ((pc < end) && !is_sep[(unsigned char)*pc]) { pc++; }
+    if (pc == end) { break; }
+
+    // Terminate the token in place, restoring the separator if it is not stored
+    char c = *pc;
+    *pc = '\0';
+    if (!strtok_add(x, token)) { *pc = c; break; }
+    pc++;
+  }
+
+  // Move the remainder to the start of the carry buffer
+  memmove(beg, rest, end - rest);
+  DSTR_LENGTH(x->i_carry) = (t_dstr_int)(end - rest);
+  beg[DSTR_LENGTH(x->i_carry)] = '\0';
+}
+
 /****************************************************************
 *  Output the string
 */
 void strtok_output(t_strtok *x)
 {
-  if (x->o_tok_cnt >= 1) {
-    outlet_anything(x->outl_any, x->o_tok_first, x->o_tok_cnt - 1, x->o_tok_arr);
+  if (x->o_tok_cnt < 1) { return; }
+
+  // A message starting with a number is output as a list
+  if (atom_gettype(x->o_tok_arr) == A_SYM) {
+    outlet_anything(x->outl_any, atom_getsym(x->o_tok_arr), x->o_tok_cnt - 1, x->o_tok_arr + 1);
+  } else {
+    outlet_list(x->outl_any, NULL, x->o_tok_cnt, x->o_tok_arr);
   }
 }
 
+/****************************************************************
+*  Tokenize the string up to a range of tokens
+*
+*  The tokens before the range are skipped without being interned,
+*  and the scan stops at the end of the range.
+*
+*  @param start The 1-based index of the first token.
+*  @param count The number of tokens, or 0 for all the remaining tokens.
+*/
+void strtok_index(t_strtok *x, long start, long count)
+{
+  t_dstr str = (x->mode == 0) ? x->i_dstr1 : x->i_dstr2;
+  t_dstr sep = (x->mode == 0) ? x->i_dstr2 : x->i_dstr1;
+
+  x->o_tok_cnt = 0;
+
+  // Test that the t_dstr strings are not NULL
+  if (DSTR_IS_NULL(x->i_dstr1) || DSTR_IS_NULL(x->i_dstr2)) {
+    object_error((t_object *)x, "Allocation error. Reset the external.");
+    return;
+  }
+
+  char is_sep[256];
+  str_sep_table(is_sep, sep);
+
+  char *pc = DSTR_CSTR(str);
+  char *end = pc + DSTR_LENGTH(str);
+  char *token;
+  char c;
+  short added;
+  long ind = 0;
+
+  while (pc < end) {
+
+    // Skip the separators, and find the end of the token
+    while ((pc < end) && is_sep[(unsigned char)*pc]) { pc++; }
+    if (pc == end) { break; }
+    token = pc;
+    while ((pc < end) && !is_sep[(unsigned char)*pc]) { pc++; }
+
+    if (++ind < start) { continue; }
+
+    // Terminate the token in place while it is stored
+    c = *pc;
+    *pc = '\0';
+    added = strtok_add(x, token);
+    *pc = c;
+
+    if (!added || (ind - start + 1 == count)) { break; }
+  }
+}
+
+/****************************************************************
+*  Store a token for output, growing the token array if necessary
+*
+*  In counting mode, the token is counted only for new text in the string
+*  buffer, and the scan is stopped otherwise.
+*
+*  @return 1 if the token was stored, 0 if the maximum count is reached.
+*/
+short strtok_add(t_strtok *x, char *token)
+{
+  if (x->counting) { return x->cnt_input ? strtok_count(x, token) : 0; }
+
+  if (x->o_tok_cnt == STR_TOK_MAX) { return 0; }
+
+  if (x->o_tok_cnt == x->o_tok_max) {
+    short max = (x->o_tok_max < STR_TOK_MAX / 2) ? 2 * x->o_tok_max : STR_TOK_MAX;
+    t_atom *arr = (t_atom *)sysmem_resizeptr(x->o_tok_arr, sizeof(t_atom) * max);
+    if (!arr) { return 0; }
+    x->o_tok_arr = arr;
+    x->o_tok_max = max;
+  }
+
+  t_atom *atom = x->o_tok_arr + x->o_tok_cnt++;
+  if (!x->typed || !str_atom_from_token(atom, token)) { atom_setsym(atom, gensym(token)); }
+
+  return 1;
+}
+
+/****************************************************************
+*  Count a token in the hash table
+*
+*  The table uses open addressing with linear probing,
+*  and is doubled when it gets half full.  If it cannot be doubled, it is
+*  filled up to one empty slot, which ends the probing, then new tokens are
+*  refused.  If the pool cannot hold a new token, the counts are cleared,
+*  so that no entry points into a lost pool.
+*
+*  @return 1 if the token was counted, 0 if there is an allocation error.
+*/
+short strtok_count(t_strtok *x, char *token)
+{
+  t_dstr_int len = (t_dstr_int)strlen(token);
+  unsigned long hash = str_hash(token, len);
+  unsigned long mask = x->cnt_max - 1;
+  unsigned long i = hash & mask;
+  t_str_count *entry;
+
+  // Probe for the token or an empty slot
+  while ((entry = x->cnt_table + i)->count) {
+    if ((entry->hash == hash) && (entry->len == len)
+      && !memcmp(DSTR_CSTR(x->cnt_pool) + entry->pos, token, len)) {
+      entry->count++;
+      return 1;
+    }
+    i = (i + 1) & mask;
+  }
+
+  // New token:  keep an empty slot, then copy it into the pool
+  if (x->cnt_num + 1 >= x->cnt_max) {
+    object_error((t_object *)x, "Counting:  Allocation error. Clear the counts.");
+    return 0;
+  }
+
+  t_dstr_int pos = DSTR_LENGTH(x->cnt_pool);
+  dstr_cat_bin(x->cnt_pool, token, len + 1);
+  if (DSTR_IS_NULL(x->cnt_pool) || DSTR_IS_CLIPPED(x->cnt_pool)) {
+    object_error((t_object *)x, "Counting:  Allocation error. The counts are cleared.");
+    strtok_clear(x);
+    return 0;
+  }
+
+  entry->hash = hash;
+  entry->pos = pos;
+  entry->len = len;
+  entry->count = 1;
+  x->cnt_num++;
+
+  // Double the table if it is half full, and rehash
+  if (2 * x->cnt_num >= x->cnt_max) {
+    long max = 2 * x->cnt_max;
+    t_str_count *table = (t_str_count *)sysmem_newptrclear(sizeof(t_str_count) * max);
+    if (!table) { return 1; }
+
+    for (long j = 0; j < x->cnt_max; j++) {
+      if (!x->cnt_table[j].count) { continue; }
+      i = x->cnt_table[j].hash & (max - 1);
+      while (table[i].count) { i = (i + 1) & (max - 1); }
+      table[i] = x->cnt_table[j];
+    }
+
+    sysmem_freeptr(x->cnt_table);
+    x->cnt_table = table;
+    x->cnt_max = max;
+  }
+
+  return 1;
+}
+
+/****************************************************************
+*  Set an atom to the int or float value of a token, if it is numeric
+*
+*  Accepts an optional sign, digits with at most one decimal point,
+*  and an optional exponent.  Integers that overflow t_atom_long are set as floats.
+*
+*  @return 1 if the token is numeric and the atom was set, 0 otherwise.
+*/
+short str_atom_from_token(t_atom *atom, char *token)
+{
+  char *pc = token;
+  unsigned __int64 ui = 0;
+  unsigned __int64 ui_max = ((unsigned __int64)1 << (8 * sizeof(t_atom_long) - 1)) - 1;
+  short digits = 0;
+  short is_float = 0;
+
+  if ((*pc == '-') || (*pc == '+')) { pc++; }
+
+  // Integer part, accumulated on the way
+  for (; (*pc >= '0') && (*pc <= '9'); pc++, digits++) {
+    if (ui > (ui_max - (*pc - '0')) / 10) { ui = ui_max + 1; }
+    else { ui = 10 * ui + (*pc - '0'); }
+  }
+
+  // Fractional part
+  if (*pc == '.') {
+    is_float = 1;
+    for (pc++; (*pc >= '0') && (*pc <= '9'); pc++) { digits++; }
+  }
+  if (digits == 0) { return 0; }
+
+  // Exponent
+  if ((*pc == 'e') || (*pc == 'E')) {
+    is_float = 1;
+    pc++;
+    if ((*pc == '-') || (*pc == '+')) { pc++; }
+    if ((*pc < '0') || (*pc > '9')) { return 0; }
+    while ((*pc >= '0') && (*pc <= '9')) { pc++; }
+  }
+  if (*pc != '\0') { return 0; }
+
+  if (is_float || (ui > ui_max)) { atom_setfloat(atom, strtod(token, NULL)); }
+  else { atom_setlong(atom, (t_atom_long)((token[0] == '-') ? -(__int64)ui : (__int64)ui)); }
+
+  return 1;
+}
+
+/****************************************************************
+*  Fill a lookup table of the separator characters
+*
+*  @param is_sep A table of 256 chars, set to 1 for separators.
+*/
+void str_sep_table(char *is_sep, t_dstr sep)
+{
+  memset(is_sep, 0, 256);
+  for (t_dstr_int i = 0; i < DSTR_LENGTH(sep); i++) { is_sep[(unsigned char)DSTR_CSTR(sep)[i]] = 1; }
+}
+
+/****************************************************************
+*  FNV-1a hash of a string
+*/
+unsigned long str_hash(const char *str, t_dstr_int len)
+{
+  unsigned __int32 hash = 2166136261u;
+  for (t_dstr_int i = 0; i < len; i++) { hash = (hash ^ (unsigned char)str[i]) * 16777619u; }
+
+  return hash;
+}
+
+/****************************************************************
+*  Comparison of token counts for qsort: by decreasing count, then by first occurrence
+*/
+int str_count_cmp(const void *a, const void *b)
+{
+  const t_str_count *ca = (const t_str_count *)a;
+  const t_str_count *cb = (const t_str_count *)b;
+
+  if (ca->count != cb->count) { return (ca->count > cb->count) ? -1 : 1; }
+  return (ca->pos < cb->pos) ? -1 : (ca->pos > cb->pos);
+}
+
 /****************************************************************
 *  Get the destination buffer depending on the proxy
 */
@@ -410,3 +914,44 @@ t_max_err str_fprecision_set(t_strtok *x, void *attr, long argc, t_atom *argv)
 
   return MAX_ERR_NONE;
 }
+
+/****************************************************************
+*  Custom setter for the streaming attribute
+*/
+t_max_err str_stream_set(t_strtok *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->stream = (long)atom_getlong(argv); } else { x->stream = 0; }
+
+  // Discard any partial token from a previous stream
+  dstr_empty(x->i_carry);
+  x->o_tok_cnt = 0;
+
+  strtok_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the typed attribute
+*/
+t_max_err str_typed_set(t_strtok *x, void *attr, long argc, t_atom *argv)
+{
+  if (argc && argv) { x->typed = (long)atom_getlong(argv); } else { x->typed = 0; }
+
+  strtok_action(x);
+  return MAX_ERR_NONE;
+}
+
+/****************************************************************
+*  Custom setter for the index attribute
+*/
+t_max_err str_index_set(t_strtok *x, void *attr, long argc, t_atom *argv)
+{
+  x->index[0] = (argc >= 1) ? (long)atom_getlong(argv) : 0;
+  x->index[1] = (argc >= 2) ? (long)atom_getlong(argv + 1) : 1;
+
+  if (x->index[0] < 0) { x->index[0] = 0; }
+  if (x->index[1] < 0) { x->index[1] = 0; }
+
+  strtok_action(x);
+  return MAX_ERR_NONE;
+}